@@ -0,0 +1,61 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Aot.hpp"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+int main(const int argc, const char *const argv[]) {
+
+    const char *image_path { nullptr };
+    const char *output_path { nullptr };
+    bool usage { false };
+
+    for (int i { 1 }; i < argc; ++i) {
+        const std::string_view arg { argv[i] };
+
+        if (arg == "-o" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (!arg.starts_with("-") && !image_path) {
+            image_path = argv[i];
+        } else {
+            usage = true;
+        }
+    }
+
+    if (usage || !image_path) {
+        std::cout << "Usage: lc3-aot [path to image file] [-o output.cpp]\n"
+                     "Compile the output against src and link it with the lc3 library, e.g.\n"
+                     "  c++ -std=c++20 -O2 -Isrc output.cpp liblc3.a -pthread -o program\n";
+        return 0;
+    }
+
+    std::ifstream file_stream { image_path, std::ios::binary };
+    if (!file_stream.is_open()) {
+        std::cout << "** Failed to read image **\n";
+        return -1;
+    }
+    const std::vector<std::uint8_t> image {
+        std::istreambuf_iterator<char> { file_stream },
+        std::istreambuf_iterator<char> {}
+    };
+
+    std::ofstream output_file;
+    if (output_path) {
+        output_file.open(output_path, std::ios::trunc);
+        if (!output_file.is_open()) {
+            std::cout << "** Failed to open output **\n";
+            return -1;
+        }
+    }
+
+    if (!Aot::translate(image.data(), image.size(), output_path ? output_file : std::cout)) {
+        std::cout << "** Failed to translate image **\n";
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Workloads.hpp"
+
+namespace {
+
+    /* Object images (origin first) assembled from bench/workloads/<name>.asm */
+
+    constexpr std::uint16_t arith[] {
+        0x3000, 0x220A, 0x240A, 0x16C2, 0x58EF, 0x9B3F, 0x16C5, 0x14BF,
+        0x03FA, 0x127F, 0x03F7, 0xF025, 0x07D0, 0x03E8,
+    };
+
+    constexpr std::uint16_t sort[] {
+        0x3000, 0x2C1A, 0x201B, 0x2219, 0x7200, 0x1021, 0x127F, 0x03FC,
+        0x2A14, 0x1B7F, 0x0C0E, 0x2012, 0x1960, 0x6200, 0x6401, 0x96BF,
+        0x16E1, 0x1643, 0x0C02, 0x7400, 0x7201, 0x1021, 0x193F, 0x03F5,
+        0x0FF0, 0x1DBF, 0x03E7, 0xF025, 0x0014, 0x0100, 0x4000,
+    };
+
+    constexpr std::uint16_t recursive[] {
+        0x3000, 0x2C17, 0x2017, 0x4801, 0xF025, 0x1DBD, 0x7F80, 0x7181,
+        0x143E, 0x0203, 0x5260, 0x1261, 0x0E08, 0x103F, 0x4FF6, 0x7382,
+        0x6181, 0x103E, 0x4FF2, 0x6582, 0x1242, 0x6F80, 0x6181, 0x1DA3,
+        0xC1C0, 0xF000, 0x0018,
+    };
+
+    constexpr std::uint16_t strings[] {
+        0x3000, 0x2209, 0xE012, 0xF022, 0xE008, 0xF024, 0x2005, 0xF021,
+        0x127F, 0x03F8, 0xF025, 0x4E20, 0x000A, 0x6170, 0x6B63, 0x6465,
+        0x7320, 0x7274, 0x6E69, 0x0067, 0x0000, 0x0054, 0x0068, 0x0065,
+        0x0020, 0x0071, 0x0075, 0x0069, 0x0063, 0x006B, 0x0020, 0x0062,
+        0x0072, 0x006F, 0x0077, 0x006E, 0x0020, 0x0066, 0x006F, 0x0078,
+        0x0020, 0x006A, 0x0075, 0x006D, 0x0070, 0x0073, 0x0020, 0x006F,
+        0x0076, 0x0065, 0x0072, 0x0020, 0x0074, 0x0068, 0x0065, 0x0020,
+        0x006C, 0x0061, 0x007A, 0x0079, 0x0020, 0x0064, 0x006F, 0x0067,
+        0x002E, 0x0020, 0x0000,
+    };
+
+    constexpr std::uint16_t kbsr[] {
+        0x3000, 0x56E0, 0x2807, 0xA207, 0x07FE, 0xA006, 0x16C0, 0x1404,
+        0x0BFA, 0xF025, 0xFF8F, 0xFE00, 0xFE02,
+    };
+
+}
+
+const std::vector<Workload> &workloads() {
+    static const std::vector<Workload> all {
+        { "arith", "Arithmetic loop over ADD/AND/NOT", arith, {} },
+        { "sort", "Bubble sort of 256 words, 20 times", sort, {} },
+        { "recursive", "Recursive fib(24) through JSR/RET", recursive, {} },
+        { "strings", "PUTS, PUTSP and OUT 20000 times each", strings, {} },
+        { "kbsr", "KBSR polling over 100000 scripted keys", kbsr, std::string(100000, 'a') + 'q' },
+    };
+    return all;
+}
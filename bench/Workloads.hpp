@@ -0,0 +1,24 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_WORKLOADS_HPP
+#define LC3VM_WORKLOADS_HPP
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* One benchmark program and the keyboard input it is run with */
+struct Workload {
+    std::string_view name;
+    std::string_view description;
+    std::span<const std::uint16_t> image; /* Origin followed by the program, in host byte order */
+    std::string input;
+};
+
+/* Every workload, in the order they are reported */
+const std::vector<Workload> &workloads();
+
+#endif //LC3VM_WORKLOADS_HPP
@@ -0,0 +1,272 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Image.hpp"
+#include "Interpreter.hpp"
+#include "Jit.hpp"
+#include "Lockstep.hpp"
+#include "Machine.hpp"
+#include "Workloads.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* Every heap allocation in the process is counted, the benchmark reports the ones made while a guest runs */
+static std::atomic<std::size_t> allocations {};
+
+/*
+ * The replacements allocate and free through these rather than calling malloc and
+ * free themselves. Inlined, GCC would see free called on what operator new returned
+ * and warn about mismatched new and delete (-Wmismatched-new-delete).
+ */
+[[gnu::noinline]] static void *allocate(const std::size_t size, const std::size_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t bytes { size ? size : 1 };
+    void *const ptr { alignment ? std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment)
+                                : std::malloc(bytes) };
+    if (!ptr) {
+        throw std::bad_alloc {};
+    }
+    return ptr;
+}
+
+[[gnu::noinline]] static void release(void *const ptr) noexcept {
+    std::free(ptr);
+}
+
+void *operator new(const std::size_t size) {
+    return allocate(size, 0);
+}
+
+void *operator new(const std::size_t size, const std::align_val_t align) {
+    return allocate(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void *const ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete(void *const ptr, std::size_t) noexcept {
+    release(ptr);
+}
+
+void operator delete(void *const ptr, std::align_val_t) noexcept {
+    release(ptr);
+}
+
+void operator delete(void *const ptr, std::size_t, std::align_val_t) noexcept {
+    release(ptr);
+}
+
+namespace {
+
+    /* Swallows guest output so the benchmark measures the VM and not the terminal */
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(const int c) override {
+            return c;
+        }
+
+        std::streamsize xsputn(const char *, const std::streamsize count) override {
+            return count;
+        }
+    };
+
+    enum Engine {
+        INTERP,
+        JIT,
+        LOCKSTEP, /* Lockstep::lanes copies of the workload at once, instructions count all of them */
+    };
+
+    constexpr std::string_view engine_name(const Engine engine) {
+        switch (engine) {
+            case JIT: return "jit";
+            case LOCKSTEP: return "lockstep";
+            default: return "interp";
+        }
+    }
+
+    struct Result {
+        std::string_view workload;
+        Engine engine;
+        std::uint64_t instructions;
+        double ns;          /* Fastest run */
+        std::size_t allocs; /* Allocations made during a run */
+
+        double ns_per_instruction() const {
+            return ns / static_cast<double>(instructions);
+        }
+
+        double mips() const {
+            return 1e3 / ns_per_instruction();
+        }
+    };
+
+    /* A fresh headless machine with the workload loaded, input is the workload's script */
+    std::unique_ptr<Machine> make_machine(const Workload &workload, std::istream &in, std::ostream &out) {
+        auto machine { std::make_unique<Machine>(in, out, Keyboard::SCRIPTED) };
+        machine->display.set_policy(Display::ON_HALT);
+
+        std::vector<std::uint8_t> bytes;
+        for (const std::uint16_t word : workload.image) {
+            bytes.push_back(word >> 8);
+            bytes.push_back(word & 0xFF);
+        }
+        Image::load(*machine, bytes.data(), bytes.size());
+        return machine;
+    }
+
+    /* Runs the workload once with a budget to find out how many instructions it executes */
+    std::uint64_t count_instructions(const Workload &workload) {
+        NullBuffer null;
+        std::ostream out { &null };
+        std::istringstream in { workload.input };
+        const auto machine { make_machine(workload, in, out) };
+
+        constexpr std::uint64_t limit { std::numeric_limits<std::uint64_t>::max() };
+        std::uint64_t budget { limit };
+        Interpreter::run(*machine, budget);
+        return limit - budget;
+    }
+
+    Result measure(const Workload &workload, const Engine engine, std::uint64_t instructions, const int reps) {
+        std::vector<Lockstep::Lane> lanes;
+        if (engine == LOCKSTEP) {
+            lanes.assign(Lockstep::lanes, { workload.input, std::numeric_limits<std::uint64_t>::max() });
+            instructions *= lanes.size();
+        }
+        Result result { workload.name, engine, instructions, std::numeric_limits<double>::max(), 0 };
+
+        for (int rep {}; rep < reps; ++rep) {
+            NullBuffer null;
+            std::ostream out { &null };
+            std::istringstream in { workload.input };
+            const auto machine { make_machine(workload, in, out) };
+            const auto lockstep { engine == LOCKSTEP ? std::make_unique<Lockstep::Engine>() : nullptr };
+
+            const std::size_t allocs_before { allocations.load(std::memory_order_relaxed) };
+            const auto start { std::chrono::steady_clock::now() };
+
+            if (engine == JIT) {
+                Jit::run(*machine);
+            } else if (engine == LOCKSTEP) {
+                lockstep->run(*machine, lanes);
+            } else {
+                Interpreter::run(*machine);
+            }
+
+            const auto end { std::chrono::steady_clock::now() };
+            result.allocs = allocations.load(std::memory_order_relaxed) - allocs_before;
+            result.ns = std::min(result.ns, std::chrono::duration<double, std::nano> { end - start }.count());
+        }
+        return result;
+    }
+
+    /* Baseline files have one "workload engine ns_per_instruction" line per result */
+    std::map<std::string, double> read_baseline(const char *const path) {
+        std::map<std::string, double> baseline;
+        std::ifstream file { path };
+        std::string workload, engine;
+        double ns_per_instruction {};
+        while (file >> workload >> engine >> ns_per_instruction) {
+            baseline[workload + ' ' + engine] = ns_per_instruction;
+        }
+        return baseline;
+    }
+
+    bool write_baseline(const char *const path, const std::vector<Result> &results) {
+        std::ofstream file { path, std::ios::trunc };
+        for (const Result &result : results) {
+            file << result.workload << ' ' << engine_name(result.engine) << ' ' << result.ns_per_instruction() << '\n';
+        }
+        return file.good();
+    }
+
+}
+
+int main(const int argc, const char *const argv[]) {
+
+    int reps { 5 };
+    const char *baseline_path { nullptr };
+    const char *save_path { nullptr };
+    std::string_view only;
+
+    for (int i { 1 }; i < argc; ++i) {
+        const std::string_view arg { argv[i] };
+
+        if (arg.starts_with("--reps=")) {
+            reps = std::max(1, std::atoi(argv[i] + arg.find('=') + 1));
+        } else if (arg.starts_with("--baseline=")) {
+            baseline_path = argv[i] + arg.find('=') + 1;
+        } else if (arg.starts_with("--save=")) {
+            save_path = argv[i] + arg.find('=') + 1;
+        } else if (arg.starts_with("--only=")) {
+            only = arg.substr(arg.find('=') + 1);
+        } else {
+            std::cout << "Usage: lc3vm_bench [--reps=N] [--only=WORKLOAD] [--baseline=FILE] [--save=FILE]\n";
+            return 0;
+        }
+    }
+
+    std::vector<Engine> engines { INTERP };
+    if (Jit::supported()) {
+        engines.push_back(JIT);
+    }
+    engines.push_back(LOCKSTEP);
+
+    const auto baseline { baseline_path ? read_baseline(baseline_path) : std::map<std::string, double> {} };
+    if (baseline_path && baseline.empty()) {
+        std::cout << "** Failed to read baseline **\n";
+        return -1;
+    }
+
+    std::cout << std::left << std::setw(11) << "workload" << std::setw(8) << "engine" << std::right
+              << std::setw(12) << "instrs" << std::setw(10) << "MIPS" << std::setw(10) << "ns/instr"
+              << std::setw(8) << "allocs" << (baseline_path ? "  vs baseline" : "") << '\n';
+    std::cout << std::fixed;
+
+    std::vector<Result> results;
+    for (const Workload &workload : workloads()) {
+        if (!only.empty() && workload.name != only) {
+            continue;
+        }
+
+        const std::uint64_t instructions { count_instructions(workload) };
+        for (const Engine engine : engines) {
+            const Result &result { results.emplace_back(measure(workload, engine, instructions, reps)) };
+
+            std::cout << std::left << std::setw(11) << result.workload << std::setw(8) << engine_name(engine)
+                      << std::right << std::setw(12) << result.instructions << std::setprecision(1)
+                      << std::setw(10) << result.mips() << std::setprecision(3) << std::setw(10)
+                      << result.ns_per_instruction() << std::setw(8) << result.allocs;
+
+            // Positive means slower than the baseline
+            const auto base { baseline.find(std::string { result.workload } + ' ' + std::string { engine_name(engine) }) };
+            if (base != baseline.end()) {
+                std::cout << std::setprecision(1) << std::showpos << std::setw(12)
+                          << 100.0 * (result.ns_per_instruction() / base->second - 1.0) << '%' << std::noshowpos;
+            }
+            std::cout << '\n';
+        }
+    }
+
+    if (save_path && !write_baseline(save_path, results)) {
+        std::cout << "** Failed to write baseline **\n";
+        return -1;
+    }
+    return 0;
+}
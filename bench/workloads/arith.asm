@@ -0,0 +1,16 @@
+; Arithmetic loop: 2000 x 1000 iterations of ADD/AND/NOT on registers
+.ORIG x3000
+        LD R1, OUTER
+OLOOP   LD R2, INNER
+ILOOP   ADD R3,R3,R2
+        AND R4,R3,#15
+        NOT R5,R4
+        ADD R3,R3,R5
+        ADD R2,R2,#-1
+        BRp ILOOP
+        ADD R1,R1,#-1
+        BRp OLOOP
+        HALT
+OUTER   .FILL #2000
+INNER   .FILL #1000
+.END
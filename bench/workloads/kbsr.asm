@@ -0,0 +1,15 @@
+; KBSR polling: reads keys through KBSR/KBDR until 'q', summing them in R3
+.ORIG x3000
+        AND R3,R3,#0
+        LD R4, NQ
+POLL    LDI R1, KBSR
+        BRzp POLL
+        LDI R0, KBDR
+        ADD R3,R3,R0
+        ADD R2,R0,R4
+        BRnp POLL
+        HALT
+NQ      .FILL #-113
+KBSR    .FILL xFE00
+KBDR    .FILL xFE02
+.END
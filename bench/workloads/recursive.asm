@@ -0,0 +1,29 @@
+; Recursive JSR: fib(24) with a stack frame per call in R6
+.ORIG x3000
+        LD R6, STACK
+        LD R0, ARG
+        JSR FIB
+        HALT
+FIB     ADD R6,R6,#-3           ; R0 = n, returns fib(n) in R1
+        STR R7,R6,#0
+        STR R0,R6,#1
+        ADD R2,R0,#-2
+        BRp REC
+        AND R1,R1,#0
+        ADD R1,R1,#1
+        BRnzp DONE
+REC     ADD R0,R0,#-1
+        JSR FIB
+        STR R1,R6,#2
+        LDR R0,R6,#1
+        ADD R0,R0,#-2
+        JSR FIB
+        LDR R2,R6,#2
+        ADD R1,R1,R2
+DONE    LDR R7,R6,#0
+        LDR R0,R6,#1
+        ADD R6,R6,#3
+        RET
+STACK   .FILL xF000
+ARG     .FILL #24
+.END
@@ -0,0 +1,33 @@
+; Memory heavy sort: fills 256 words in descending order and bubble sorts them, 20 times
+.ORIG x3000
+        LD R6, PASSES
+PASS    LD R0, ARRAY            ; fill ARRAY[i] = N - i
+        LD R1, N
+FILL    STR R1,R0,#0
+        ADD R0,R0,#1
+        ADD R1,R1,#-1
+        BRp FILL
+        LD R5, N                ; R5 = unsorted length
+OUTERS  ADD R5,R5,#-1
+        BRnz SORTED
+        LD R0, ARRAY
+        ADD R4,R5,#0
+INNERS  LDR R1,R0,#0
+        LDR R2,R0,#1
+        NOT R3,R2
+        ADD R3,R3,#1
+        ADD R3,R1,R3            ; R1 - R2
+        BRnz NOSWAP
+        STR R2,R0,#0
+        STR R1,R0,#1
+NOSWAP  ADD R0,R0,#1
+        ADD R4,R4,#-1
+        BRp INNERS
+        BRnzp OUTERS
+SORTED  ADD R6,R6,#-1
+        BRp PASS
+        HALT
+PASSES  .FILL #20
+N       .FILL #256
+ARRAY   .FILL x4000
+.END
@@ -0,0 +1,24 @@
+; String output: PUTS, PUTSP and OUT 20000 times each
+.ORIG x3000
+        LD R1, COUNT
+LOOP    LEA R0, TEXT
+        PUTS
+        LEA R0, PACKED
+        PUTSP
+        LD R0, NEWLINE
+        OUT
+        ADD R1,R1,#-1
+        BRp LOOP
+        HALT
+COUNT   .FILL #20000
+NEWLINE .FILL x0A
+PACKED  .FILL x6170             ; "packed string"
+        .FILL x6B63
+        .FILL x6465
+        .FILL x7320
+        .FILL x7274
+        .FILL x6E69
+        .FILL x0067
+        .FILL x0000
+TEXT    .STRINGZ "The quick brown fox jumps over the lazy dog. "
+.END
@@ -0,0 +1,398 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Aot.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include "Decode.hpp"
+#include "Memory.hpp"
+#include "Opcodes.hpp"
+#include "Registers.hpp"
+#include "Trap.hpp"
+
+namespace {
+
+    /* Prints a word the way the emitted source spells addresses and constants, e.g. 0x3000 */
+    struct Hex {
+        std::uint16_t val;
+    };
+
+    std::ostream &operator<<(std::ostream &os, const Hex hex) {
+        const auto flags { os.flags() };
+        const auto fill { os.fill('0') };
+        os << "0x" << std::uppercase << std::hex << std::setw(4) << hex.val;
+        os.flags(flags);
+        os.fill(fill);
+        return os;
+    }
+
+    /* Label of the block starting at an address */
+    struct Label {
+        std::uint16_t addr;
+    };
+
+    std::ostream &operator<<(std::ostream &os, const Label label) {
+        const auto flags { os.flags() };
+        const auto fill { os.fill('0') };
+        os << "B_" << std::uppercase << std::hex << std::setw(4) << label.addr;
+        os.flags(flags);
+        os.fill(fill);
+        return os;
+    }
+
+    /* Register r of the emitted run function */
+    struct Reg {
+        std::uint8_t r;
+    };
+
+    std::ostream &operator<<(std::ostream &os, const Reg reg) {
+        return os << "r[" << static_cast<int>(reg.r) << ']';
+    }
+
+    /* Instructions that end a basic block, all of them transfer control or stop */
+    bool ends_block(const Decode::Instr &instr) {
+        switch (instr.handler) {
+            case Decode::BR:
+            case Decode::JSR:
+            case Decode::JSRR:
+            case Decode::JMP:
+            case Decode::HALT:
+            case Decode::RTI:
+            case Decode::RES:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    class Translator {
+    public:
+        Translator(const std::uint8_t *const data, const std::size_t size) : data { data }, size { size } {
+            origin = data[0] << 8 | data[1];
+            end = std::min(origin + (size - sizeof(std::uint16_t)) / sizeof(std::uint16_t), Memory::mem_amt);
+            for (std::size_t addr { origin }; addr < end; ++addr) {
+                const std::size_t offset { sizeof(std::uint16_t) * (addr - origin + 1) };
+                mem[addr] = static_cast<std::uint16_t>(data[offset] << 8 | data[offset + 1]);
+            }
+        }
+
+        /* Follows control flow from pc_start and splits what it reaches into basic blocks */
+        void discover() {
+            lead(Registers::pc_start);
+
+            while (!pending.empty()) {
+                const std::uint16_t addr { pending.back() };
+                pending.pop_back();
+                visit(addr);
+            }
+
+            for (std::size_t addr { origin }; addr < end; ++addr) {
+                if (!leader[addr] || !code[addr]) {
+                    continue;
+                }
+                std::size_t last { addr };
+                while (!ends_block(Decode::decode(mem[last])) && last + 1 < end && code[last + 1] && !leader[last + 1]) {
+                    ++last;
+                }
+                blocks.push_back({ static_cast<std::uint16_t>(addr), static_cast<std::uint16_t>(last) });
+            }
+        }
+
+        void emit(std::ostream &os) const {
+            os << "// Generated by lc3-aot from an LC-3 object image\n\n"
+                  "#include <array>\n"
+                  "#include <cstdint>\n"
+                  "#include \"AotRuntime.hpp\"\n"
+                  "#include \"Opcodes.hpp\"\n"
+                  "#include \"Registers.hpp\"\n"
+                  "#include \"Trap.hpp\"\n\n"
+                  "namespace {\n\n";
+
+            // The image itself is loaded as is, the interpreter needs it and the program may read it as data
+            os << "    constexpr std::array<std::uint8_t, " << size << "> image {\n";
+            for (std::size_t i {}; i < size; ++i) {
+                os << (i % 16 == 0 ? "        " : " ") << static_cast<int>(data[i]) << ','
+                   << (i % 16 == 15 || i + 1 == size ? "\n" : "");
+            }
+            os << "    };\n\n";
+
+            os << "    constexpr std::array<Aot::Block, " << blocks.size() << "> blocks {{\n";
+            for (const auto &[first, last] : blocks) {
+                os << "        { " << Hex { first } << ", " << Hex { last } << " },\n";
+            }
+            os << "    }};\n\n";
+
+            os << "    void run(Machine &m, Aot::Code &code) {\n"
+                  "        std::array<std::uint16_t, Registers::PC> r {};\n"
+                  "        std::uint16_t pc {};\n"
+                  "        std::uint16_t cond {};\n\n"
+                  "        /* Copies the guest state between the locals and the machine's registers */\n"
+                  "        const auto load = [&] {\n"
+                  "            for (std::size_t i {}; i < r.size(); ++i) {\n"
+                  "                r[i] = m.regs[i];\n"
+                  "            }\n"
+                  "            pc = m.regs[Registers::PC];\n"
+                  "            cond = m.regs[Registers::COND];\n"
+                  "        };\n"
+                  "        const auto store = [&](const std::uint16_t next) {\n"
+                  "            for (std::size_t i {}; i < r.size(); ++i) {\n"
+                  "                m.regs[i] = r[i];\n"
+                  "            }\n"
+                  "            m.regs[Registers::PC] = next;\n"
+                  "            m.regs[Registers::COND] = cond;\n"
+                  "        };\n\n"
+                  "        load();\n"
+                  "        goto dispatch;\n";
+
+            for (std::size_t i {}; i < blocks.size(); ++i) {
+                emit_block(os, i);
+            }
+
+            os << "\n    dispatch:\n"
+                  "        if (!m.running()) [[unlikely]] {\n"
+                  "            store(pc);\n"
+                  "            return;\n"
+                  "        }\n"
+                  "        switch (pc) {\n";
+            for (const auto &block : blocks) {
+                os << "            case " << Hex { block.first } << ": goto " << Label { block.first } << ";\n";
+            }
+            os << "            default: break;\n"
+                  "        }\n\n"
+                  "    interpret:\n"
+                  "        store(pc);\n"
+                  "        if (!Aot::step(m)) {\n"
+                  "            return;\n"
+                  "        }\n"
+                  "        load();\n"
+                  "        goto dispatch;\n"
+                  "    }\n\n"
+                  "}\n\n"
+                  "int main(const int argc, const char *const argv[]) {\n"
+                  "    return Aot::main(argc, argv, image.data(), image.size(), blocks.data(), blocks.size(), &run);\n"
+                  "}\n";
+        }
+
+    private:
+        const std::uint8_t *data;
+        std::size_t size;
+        std::size_t origin {};
+        std::size_t end {};
+
+        std::vector<std::uint16_t> mem = std::vector<std::uint16_t>(Memory::mem_amt);
+        std::vector<bool> code = std::vector<bool>(Memory::mem_amt);   /* Reached by control flow */
+        std::vector<bool> leader = std::vector<bool>(Memory::mem_amt); /* Starts a basic block */
+        std::vector<std::uint16_t> pending;
+        std::vector<Aot::Block> blocks;
+
+        bool in_image(const std::size_t addr) const {
+            return addr >= origin && addr < end;
+        }
+
+        void lead(const std::uint16_t addr) {
+            if (in_image(addr)) {
+                leader[addr] = true;
+                pending.push_back(addr);
+            }
+        }
+
+        void follow(const std::uint16_t addr) {
+            if (in_image(addr)) {
+                pending.push_back(addr);
+            }
+        }
+
+        void visit(const std::uint16_t addr) {
+            if (code[addr]) {
+                return;
+            }
+            code[addr] = true;
+
+            const Decode::Instr instr { Decode::decode(mem[addr]) };
+            const std::uint16_t next ( addr + 1 );
+            const std::uint16_t target ( next + instr.imm );
+
+            switch (instr.handler) {
+                case Decode::BR:
+                    lead(target);
+                    if (instr.dr != (CondFlags::NEG | CondFlags::ZERO | CondFlags::POS)) {
+                        lead(next);
+                    }
+                    break;
+                case Decode::JSR:
+                    lead(target);
+                    lead(next);
+                    break;
+                case Decode::JSRR:
+                    lead(next);
+                    break;
+                case Decode::JMP:
+                case Decode::HALT:
+                case Decode::RTI:
+                case Decode::RES:
+                    break;
+                case Decode::LEA:
+                    // Most likely the address of a subroutine for JSRR or JMP
+                    lead(target);
+                    follow(next);
+                    break;
+                default:
+                    follow(next);
+                    break;
+            }
+        }
+
+        /* Continues at addr, directly if it starts a block */
+        void jump(std::ostream &os, const std::uint16_t addr) const {
+            if (code[addr] && leader[addr]) {
+                os << "goto " << Label { addr } << ';';
+            } else {
+                os << "{ pc = " << Hex { addr } << "; goto dispatch; }";
+            }
+        }
+
+        void emit_block(std::ostream &os, const std::size_t index) const {
+            const auto [first, last] { blocks[index] };
+
+            os << "\n    " << Label { first } << ":\n"
+               << "        if (code.dirty(" << index << ")) [[unlikely]] {\n"
+               << "            pc = " << Hex { first } << ";\n"
+               << "            goto interpret;\n"
+               << "        }\n";
+
+            for (std::size_t addr { first }; addr <= last; ++addr) {
+                emit_instr(os, static_cast<std::uint16_t>(addr));
+            }
+
+            const Decode::Instr instr { Decode::decode(mem[last]) };
+            if (!ends_block(instr) || (instr.handler == Decode::BR && instr.dr != 7)) {
+                os << "        ";
+                jump(os, static_cast<std::uint16_t>(last + 1));
+                os << '\n';
+            }
+        }
+
+        void emit_instr(std::ostream &os, const std::uint16_t addr) const {
+            const Decode::Instr in { Decode::decode(mem[addr]) };
+            const std::uint16_t next ( addr + 1 );
+            const std::uint16_t target ( next + in.imm );
+            const Reg dr { in.dr };
+            const Reg sr1 { in.sr1 };
+
+            os << "        ";
+            const auto set_cond = [&] {
+                os << " cond = Opcodes::cond_of(" << dr << ");\n";
+            };
+            // Stores that overwrite translated code leave the block, the rest of it may be stale
+            const auto store = [&](const auto &address) {
+                os << "if (code.store(m, " << address << ", " << dr << ")) { pc = " << Hex { next } << "; goto dispatch; }\n";
+            };
+
+            switch (in.handler) {
+                case Decode::BR:
+                    if (in.dr == (CondFlags::NEG | CondFlags::ZERO | CondFlags::POS)) {
+                        jump(os, target);
+                    } else if (in.dr != 0) {
+                        os << "if (cond & " << static_cast<int>(in.dr) << ") ";
+                        jump(os, target);
+                    } else {
+                        os << "/* BR without flags, never taken */";
+                    }
+                    os << '\n';
+                    break;
+                case Decode::ADD_REG:
+                    os << dr << " = " << sr1 << " + " << Reg { in.sr2 } << ';';
+                    set_cond();
+                    break;
+                case Decode::ADD_IMM:
+                    os << dr << " = " << sr1 << " + " << Hex { in.imm } << ';';
+                    set_cond();
+                    break;
+                case Decode::AND_REG:
+                    os << dr << " = " << sr1 << " & " << Reg { in.sr2 } << ";\n";
+                    break;
+                case Decode::AND_IMM:
+                    os << dr << " = " << sr1 << " & " << Hex { in.imm } << ";\n";
+                    break;
+                case Decode::NOT:
+                    os << dr << " = ~" << sr1 << ';';
+                    set_cond();
+                    break;
+                case Decode::LEA:
+                    os << dr << " = " << Hex { target } << ';';
+                    set_cond();
+                    break;
+                case Decode::LD:
+                    os << dr << " = m.read(" << Hex { target } << ");";
+                    set_cond();
+                    break;
+                case Decode::LDI:
+                    os << dr << " = m.read(m.read(" << Hex { target } << "));";
+                    set_cond();
+                    break;
+                case Decode::LDR:
+                    os << dr << " = m.read(" << sr1 << " + " << Hex { in.imm } << ");";
+                    set_cond();
+                    break;
+                case Decode::ST:
+                    if (code[target] || target >= Memory::io_start) {
+                        store(Hex { target });
+                    } else {
+                        os << "m.write(" << Hex { target } << ", " << dr << ");\n";
+                    }
+                    break;
+                case Decode::STI: {
+                    std::ostringstream address;
+                    address << "m.read(" << Hex { target } << ')';
+                    store(address.str());
+                    break;
+                }
+                case Decode::STR: {
+                    std::ostringstream address;
+                    address << sr1 << " + " << Hex { in.imm };
+                    store(address.str());
+                    break;
+                }
+                case Decode::JSR:
+                    os << "r[7] = " << Hex { next } << "; ";
+                    jump(os, target);
+                    os << '\n';
+                    break;
+                // R7 is written before the base register is read, matching Opcodes::exec<JSR>
+                case Decode::JSRR:
+                    os << "r[7] = " << Hex { next } << "; pc = " << sr1 << "; goto dispatch;\n";
+                    break;
+                case Decode::JMP:
+                    os << "pc = " << sr1 << "; goto dispatch;\n";
+                    break;
+                case Decode::TRAP:
+                    os << "store(" << Hex { next } << "); Opcodes::exec<Opcodes::TRAP>(m, " << Hex { in.word }
+                       << "); load();\n";
+                    break;
+                case Decode::HALT:
+                    os << "store(" << Hex { next } << "); Trap::exec<Trap::HALT>(m); return;\n";
+                    break;
+                default:
+                    // RTI, RES and unknown traps panic, exactly like lc3vm
+                    os << "store(" << Hex { next } << "); Opcodes::opcode_funcs[" << (in.word >> 12) << "](m, "
+                       << Hex { in.word } << "); return;\n";
+                    break;
+            }
+        }
+    };
+
+}
+
+bool Aot::translate(const std::uint8_t *const data, const std::size_t size, std::ostream &out) {
+    if (size < sizeof(std::uint16_t)) {
+        return false;
+    }
+
+    Translator translator { data, size };
+    translator.discover();
+    translator.emit(out);
+    return out.good();
+}
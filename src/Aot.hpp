@@ -0,0 +1,35 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_AOT_HPP
+#define LC3VM_AOT_HPP
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+namespace Aot {
+
+    /* The words of one translated basic block, first through last */
+    struct Block {
+        std::uint16_t first;
+        std::uint16_t last;
+    };
+
+    /*
+     * Translates an object image into the C++ source of a program that runs it like
+     * lc3vm does. Control flow is followed from pc_start (and from every LEA target,
+     * which is how JSRR and JMP usually get their address) and each basic block
+     * becomes a label in one function. Direct branches and JSR jump straight to
+     * their label, JMP, JSRR and RET go through a switch on PC. Anything that was
+     * not translated, or that the guest overwrote, runs on the embedded interpreter
+     * (Aot::step), so the result matches lc3vm for self modifying programs too.
+     *
+     * The output includes AotRuntime.hpp and must be linked against the lc3 library.
+     * Returns false if the image is too short to have an origin.
+     */
+    bool translate(const std::uint8_t *data, std::size_t size, std::ostream &out);
+
+}
+
+#endif //LC3VM_AOT_HPP
@@ -0,0 +1,73 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "AotRuntime.hpp"
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include "Image.hpp"
+#include "Opcodes.hpp"
+#include "PlatformSpecific.hpp"
+#include "Registers.hpp"
+#include "Trap.hpp"
+
+Aot::Code::Code(const Block *const blocks, const std::size_t count) : dirty_blocks(count) {
+    for (std::size_t i {}; i < count; ++i) {
+        for (std::size_t addr { blocks[i].first }; addr <= blocks[i].last; ++addr) {
+            block_of[addr] = static_cast<std::uint16_t>(i + 1);
+        }
+    }
+}
+
+bool Aot::step(Machine &m) {
+    const std::uint16_t pc { m.read_reg(Registers::PC) };
+    const std::uint16_t instr { m.mem[pc] };
+
+    m.write_reg(Registers::PC, pc + 1);
+    // Any TRAP x25 halts, the vector is only the low byte like Decode::decode reads it
+    if (instr >> 12 == Opcodes::TRAP && (instr & 0xFF) == Trap::HALT) {
+        Trap::exec<Trap::HALT>(m);
+        return false;
+    }
+    Opcodes::opcode_funcs[instr >> 12](m, instr);
+    return m.running();
+}
+
+namespace {
+
+    void handle_interrupt(const int) {
+        restore_input_buffering();
+        std::cout << "\n** Program Terminated **\n";
+        std::exit(-2);
+    }
+
+}
+
+int Aot::main(const int argc, const char *const argv[], const std::uint8_t *const image, const std::size_t size,
+              const Block *const blocks, const std::size_t count, const run_func_t run) {
+    // The only option is --headless, which leaves the terminal alone like lc3vm --headless
+    const bool headless { argc > 1 && std::string_view { argv[1] } == "--headless" };
+
+    const auto machine { headless ? std::make_unique<Machine>(std::cin, std::cout, Keyboard::SCRIPTED)
+                                  : std::make_unique<Machine>() };
+    if (headless) {
+        machine->display.set_policy(Display::ON_HALT);
+    }
+    Image::load(*machine, image, size);
+
+    const auto code { std::make_unique<Code>(blocks, count) };
+
+    if (!headless) {
+        std::signal(SIGINT, handle_interrupt);
+        disable_input_buffering();
+    }
+
+    run(*machine, *code);
+
+    if (!headless) {
+        restore_input_buffering();
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_AOTRUNTIME_HPP
+#define LC3VM_AOTRUNTIME_HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Aot.hpp"
+#include "Machine.hpp"
+#include "Memory.hpp"
+
+/* Support code for programs emitted by lc3-aot (see Aot::translate) */
+namespace Aot {
+
+    /*
+     * Which words were translated and which blocks the guest has written to
+     * since. A dirty block is never entered again, the embedded interpreter runs
+     * those words instead.
+     */
+    class Code {
+    public:
+        Code(const Block *blocks, std::size_t count);
+
+        /* Whether block (its index in the emitted block list) was overwritten */
+        bool dirty(const std::size_t block) const {
+            return dirty_blocks[block];
+        }
+
+        /* Stores val and returns true if it overwrote translated code or stopped the machine, either way the block must stop running */
+        bool store(Machine &m, const std::uint16_t addr, const std::uint16_t val) {
+            if (!m.write(addr, val)) [[unlikely]] {
+                return true;
+            }
+            if (block_of[addr] == 0) [[likely]] {
+                return false;
+            }
+            dirty_blocks[block_of[addr] - 1] = true;
+            return true;
+        }
+
+    private:
+        std::array<std::uint16_t, Memory::mem_amt> block_of {}; /* Block index + 1 of every translated word, 0 for none */
+        std::vector<bool> dirty_blocks;
+    };
+
+    /*
+     * The embedded interpreter: executes the instruction at the machine's PC with
+     * Opcodes::exec. Returns false once the program halted or stopped the machine.
+     */
+    bool step(Machine &);
+
+    using run_func_t = void (*)(Machine &, Code &);
+
+    /* main of an emitted program, runs the translated code like lc3vm runs the image */
+    int main(int argc, const char *const argv[], const std::uint8_t *image, std::size_t size,
+             const Block *blocks, std::size_t count, run_func_t run);
+
+}
+
+#endif //LC3VM_AOTRUNTIME_HPP
@@ -0,0 +1,366 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Batch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "Image.hpp"
+#include "Interpreter.hpp"
+#include "Lockstep.hpp"
+#include "Machine.hpp"
+
+namespace {
+
+    struct Job {
+        std::size_t index;
+        std::string image;    /* As written in the manifest, for the result */
+        std::filesystem::path image_path;
+        std::filesystem::path input_path;    /* Empty for no input */
+        std::filesystem::path expected_path; /* Empty for no expected output */
+        std::uint64_t limit;
+        bool malformed;
+    };
+
+    struct Result {
+        std::string_view status;
+        std::uint64_t instructions {};
+        double ms {};
+        std::optional<bool> passed;
+        std::string output;
+        std::string_view error;
+
+        bool failed() const {
+            return status != "halted" || passed == false;
+        }
+    };
+
+    std::optional<std::vector<Job>> read_manifest(const char *const path, const std::uint64_t limit) {
+        std::ifstream manifest { path };
+        if (!manifest.is_open()) {
+            return std::nullopt;
+        }
+
+        const std::filesystem::path base { std::filesystem::path { path }.parent_path() };
+        const auto resolve = [&](const std::string &file) {
+            return file.empty() || file == "-" ? std::filesystem::path {} : base / file;
+        };
+
+        std::vector<Job> jobs;
+        std::string line;
+        while (std::getline(manifest, line)) {
+            std::istringstream fields { line };
+            std::string image, input, expected, job_limit;
+            if (!(fields >> image) || image.starts_with('#')) {
+                continue;
+            }
+            fields >> input >> expected >> job_limit;
+
+            Job &job { jobs.emplace_back(Job { jobs.size(), image, base / image, resolve(input),
+                                               resolve(expected), limit, false }) };
+            if (!job_limit.empty()) {
+                const auto [end, ec] { std::from_chars(job_limit.data(), job_limit.data() + job_limit.size(), job.limit) };
+                job.malformed = ec != std::errc {} || end != job_limit.data() + job_limit.size();
+            }
+            std::string extra;
+            job.malformed = job.malformed || static_cast<bool>(fields >> extra);
+        }
+        return jobs;
+    }
+
+    bool read_file(const std::filesystem::path &path, std::string &contents) {
+        std::ifstream file { path, std::ios::binary };
+        if (!file.is_open()) {
+            return false;
+        }
+        contents.assign(std::istreambuf_iterator<char> { file }, std::istreambuf_iterator<char> {});
+        return !file.bad();
+    }
+
+    /*
+     * Every job gets a fresh machine, built in storage its worker keeps for all its jobs.
+     * The pages stay mapped, so a job costs a clear instead of page faults on all of them.
+     */
+    struct Slot {
+        alignas(Machine) std::byte bytes[sizeof(Machine)];
+    };
+
+    struct Destroy {
+        void operator()(Machine *const m) const {
+            m->~Machine();
+        }
+    };
+
+    std::string_view status_of(const Interpreter::Stop stop) {
+        switch (stop) {
+            case Interpreter::HALTED:
+                return "halted";
+            case Interpreter::FAULTED:
+                return "faulted";
+            default:
+                return "limit";
+        }
+    }
+
+    /* Reads the job's input and expected output, or fails the result */
+    bool read_job_files(const Job &job, std::string &input, std::string &expected, Result &result) {
+        if (job.malformed) {
+            result.status = "error";
+            result.error = "malformed manifest line";
+            return false;
+        }
+        if (!job.input_path.empty() && !read_file(job.input_path, input)) {
+            result.status = "error";
+            result.error = "failed to read input";
+            return false;
+        }
+        if (!job.expected_path.empty() && !read_file(job.expected_path, expected)) {
+            result.status = "error";
+            result.error = "failed to read expected output";
+            return false;
+        }
+        return true;
+    }
+
+    /* Compares the output with the expected one if the job has it, otherwise keeps it for the result */
+    void check_output(const Job &job, std::string &&output, const std::string &expected, Result &result) {
+        if (job.expected_path.empty()) {
+            result.output = std::move(output);
+        } else {
+            result.passed = output == expected;
+        }
+    }
+
+    Result run_job(const Job &job, Slot &slot) {
+        Result result {};
+        std::string input, expected;
+        if (!read_job_files(job, input, expected, result)) {
+            return result;
+        }
+
+        const auto start { std::chrono::steady_clock::now() };
+
+        std::istringstream in { std::move(input) };
+        std::ostringstream out;
+        const std::unique_ptr<Machine, Destroy> machine { new (slot.bytes) Machine { in, out, Keyboard::SCRIPTED } };
+        machine->display.set_policy(Display::ON_HALT);
+        if (!Image::read(*machine, job.image_path.c_str())) {
+            result.status = "error";
+            result.error = "failed to read image";
+            return result;
+        }
+
+        std::uint64_t budget { job.limit };
+        result.status = status_of(Interpreter::run(*machine, budget));
+        result.instructions = job.limit - budget;
+        machine->display.flush();
+
+        result.ms = std::chrono::duration<double, std::milli> { std::chrono::steady_clock::now() - start }.count();
+        check_output(job, std::move(out).str(), expected, result);
+        return result;
+    }
+
+    /* Runs jobs that share an image side by side on the lockstep engine, ms is the time of the whole group */
+    std::vector<Result> run_lockstep(const std::vector<Job> &jobs, const std::vector<std::size_t> &group, Slot &slot,
+                                     Lockstep::Engine &engine) {
+        std::vector<Result> results(group.size());
+        std::vector<std::string> inputs(group.size()), expected(group.size());
+        std::vector<Lockstep::Lane> lanes;
+        std::vector<std::size_t> lane_of(group.size(), group.size());
+        for (std::size_t i {}; i < group.size(); ++i) {
+            if (read_job_files(jobs[group[i]], inputs[i], expected[i], results[i])) {
+                lane_of[i] = lanes.size();
+                lanes.push_back({ inputs[i], jobs[group[i]].limit });
+            }
+        }
+
+        const auto start { std::chrono::steady_clock::now() };
+
+        std::istringstream in;
+        std::ostringstream out;
+        const std::unique_ptr<Machine, Destroy> machine { new (slot.bytes) Machine { in, out, Keyboard::SCRIPTED } };
+        const bool loaded { Image::read(*machine, jobs[group.front()].image_path.c_str()) };
+        if (loaded) {
+            engine.run(*machine, lanes);
+        }
+
+        const double ms { std::chrono::duration<double, std::milli> { std::chrono::steady_clock::now() - start }.count() };
+        for (std::size_t i {}; i < group.size(); ++i) {
+            if (lane_of[i] == group.size()) {
+                continue;
+            }
+            Result &result { results[i] };
+            if (!loaded) {
+                result.status = "error";
+                result.error = "failed to read image";
+                continue;
+            }
+            Lockstep::Lane &lane { lanes[lane_of[i]] };
+            result.status = status_of(lane.stop);
+            result.instructions = lane.executed;
+            result.ms = ms;
+            check_output(jobs[group[i]], std::move(lane.output), expected[i], result);
+        }
+        return results;
+    }
+
+    void write_json_string(std::ostream &os, const std::string_view text) {
+        os << '"';
+        for (const char c : text) {
+            switch (c) {
+                case '"': os << "\\\""; break;
+                case '\\': os << "\\\\"; break;
+                case '\n': os << "\\n"; break;
+                case '\r': os << "\\r"; break;
+                case '\t': os << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20 || static_cast<unsigned char>(c) >= 0x7F) {
+                        // Guest output is bytes, anything outside printable ASCII is passed on as its code point
+                        os << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                           << static_cast<unsigned>(static_cast<unsigned char>(c)) << std::dec;
+                    } else {
+                        os << c;
+                    }
+                    break;
+            }
+        }
+        os << '"';
+    }
+
+    void write_result(std::ostream &os, const Job &job, const Result &result) {
+        os << "{\"job\":" << job.index << ",\"image\":";
+        write_json_string(os, job.image);
+        os << ",\"status\":\"" << result.status << "\",\"instructions\":" << result.instructions
+           << ",\"ms\":" << std::fixed << std::setprecision(3) << result.ms;
+        if (!result.error.empty()) {
+            os << ",\"error\":\"" << result.error << '"';
+        } else if (result.passed) {
+            os << ",\"passed\":" << (*result.passed ? "true" : "false");
+        } else {
+            os << ",\"output\":";
+            write_json_string(os, result.output);
+        }
+        os << "}\n";
+    }
+
+    /*
+     * Jobs are handed out in groups that run together, a group is a single job unless
+     * the lockstep engine runs it. Lockstep groups are jobs with the same image, as
+     * many as the engine has lanes.
+     */
+    std::vector<std::vector<std::size_t>> make_groups(const std::vector<Job> &jobs, const bool lockstep) {
+        std::vector<std::vector<std::size_t>> groups;
+        std::map<std::filesystem::path, std::size_t> filling; /* The group each image's next job joins */
+        for (const Job &job : jobs) {
+            if (!lockstep || job.malformed) {
+                groups.push_back({ job.index });
+                continue;
+            }
+            const auto [group, added] { filling.try_emplace(job.image_path, groups.size()) };
+            if (added || groups[group->second].size() == Lockstep::lanes) {
+                group->second = groups.size();
+                groups.emplace_back();
+            }
+            groups[group->second].push_back(job.index);
+        }
+        return groups;
+    }
+
+    /* One worker's share of the groups. It takes from the back, thieves take from the front */
+    struct alignas(64) Queue {
+        std::mutex lock;
+        std::deque<std::size_t> groups;
+    };
+
+    std::optional<std::size_t> take(std::vector<Queue> &queues, const std::size_t self) {
+        {
+            Queue &own { queues[self] };
+            const std::lock_guard lock { own.lock };
+            if (!own.groups.empty()) {
+                const std::size_t group { own.groups.back() };
+                own.groups.pop_back();
+                return group;
+            }
+        }
+
+        // No job creates more jobs, so once every queue is empty the worker is done
+        for (std::size_t i { 1 }; i < queues.size(); ++i) {
+            Queue &victim { queues[(self + i) % queues.size()] };
+            const std::lock_guard lock { victim.lock };
+            if (!victim.groups.empty()) {
+                const std::size_t group { victim.groups.front() };
+                victim.groups.pop_front();
+                return group;
+            }
+        }
+        return std::nullopt;
+    }
+
+}
+
+std::optional<std::size_t> Batch::run(const char *const manifest, std::ostream &results, const Options &options) {
+    const auto jobs { read_manifest(manifest, options.limit) };
+    if (!jobs) {
+        return std::nullopt;
+    }
+
+    const auto groups { make_groups(*jobs, options.lockstep) };
+    const std::size_t threads { std::max<std::size_t>(1, std::min<std::size_t>(
+        options.threads ? options.threads : std::thread::hardware_concurrency(), groups.size())) };
+
+    std::vector<Queue> queues(threads);
+    for (std::size_t i {}; i < groups.size(); ++i) {
+        queues[i % threads].groups.push_back(i);
+    }
+
+    std::mutex results_lock;
+    std::atomic<std::size_t> failed {};
+
+    const auto work = [&](const std::size_t self) {
+        const auto slot { std::make_unique<Slot>() };
+        const auto engine { options.lockstep ? std::make_unique<Lockstep::Engine>() : nullptr };
+        std::ostringstream lines;
+        while (const auto index { take(queues, self) }) {
+            const std::vector<std::size_t> &group { groups[*index] };
+            const std::vector<Result> group_results { group.size() == 1
+                ? std::vector<Result> { run_job((*jobs)[group.front()], *slot) }
+                : run_lockstep(*jobs, group, *slot, *engine) };
+
+            lines.str({});
+            for (std::size_t i {}; i < group.size(); ++i) {
+                if (group_results[i].failed()) {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                }
+                write_result(lines, (*jobs)[group[i]], group_results[i]);
+            }
+            const std::lock_guard lock { results_lock };
+            results << lines.view() << std::flush;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t i { 1 }; i < threads; ++i) {
+        workers.emplace_back(work, i);
+    }
+    work(0);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    return failed.load();
+}
@@ -0,0 +1,48 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_BATCH_HPP
+#define LC3VM_BATCH_HPP
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+
+namespace Batch {
+
+    struct Options {
+        std::uint64_t limit { 1'000'000'000 }; /* Instructions per job unless its manifest line says otherwise */
+        unsigned threads {};                    /* Workers, 0 for one per core */
+        bool lockstep {};                       /* Run jobs with the same image together on the lockstep engine */
+    };
+
+    /*
+     * Runs every job in a manifest, each on its own headless machine, on a pool of
+     * worker threads that steal jobs from each other once their own share is done.
+     *
+     * A manifest has one job per line: IMAGE [INPUT [EXPECTED [LIMIT]]], separated
+     * by whitespace, with - for a file that is not given. INPUT is the keyboard
+     * script, EXPECTED the output the job has to print to pass, and LIMIT overrides
+     * the instruction limit. Relative paths are relative to the manifest. Blank lines
+     * and lines starting with # are skipped.
+     *
+     * Every finished job writes one JSON object on its own line to results, in the
+     * order the jobs finish:
+     *   {"job":0,"image":"a.obj","status":"halted","instructions":120,"ms":0.05,"passed":true}
+     * status is halted, limit (the job ran out of instructions), faulted (RTI, a
+     * reserved opcode or an unknown trap) or error (the files could not be read,
+     * with an "error" message). Jobs with an EXPECTED file get "passed", the others
+     * get their "output".
+     *
+     * With lockstep, jobs that share an image run in groups on Lockstep::Engine,
+     * their results come out together and "ms" is the time of the whole group.
+     *
+     * Returns the number of jobs that did not halt or did not pass, or nothing if
+     * the manifest could not be read.
+     */
+    std::optional<std::size_t> run(const char *manifest, std::ostream &results, const Options &options);
+
+}
+
+#endif //LC3VM_BATCH_HPP
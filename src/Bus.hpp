@@ -0,0 +1,86 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_BUS_HPP
+#define LC3VM_BUS_HPP
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include "Memory.hpp"
+
+class Machine;
+
+/*
+ * A memory mapped device. It gets every load and store of the registers it is
+ * attached at, mem holds whatever the guest should see there (a snapshot of
+ * mem is a snapshot of the device registers too).
+ */
+class Device {
+public:
+    virtual ~Device() = default;
+
+    virtual std::uint16_t read(Machine &m, std::uint16_t addr) = 0;
+    virtual void write(Machine &m, std::uint16_t addr, std::uint16_t val) = 0;
+};
+
+/*
+ * Routes loads and stores to devices. Memory is split into pages and a page is
+ * either plain RAM or I/O: only accesses to I/O pages look for a device, so RAM
+ * costs one table lookup and no comparisons against device registers. Devices
+ * live in the I/O region (Memory::io_start and up), words there with no device
+ * attached behave like RAM.
+ *
+ * Watchpoints use the same pages: a watched word anywhere in memory makes its
+ * page an I/O page, so only stores to that page pay for checking it.
+ */
+class Bus {
+public:
+    static constexpr std::size_t page_words { 256 };
+    static constexpr std::size_t page_count { Memory::mem_amt / page_words };
+
+    /* Whether addr is on a page with devices */
+    bool io(const std::uint16_t addr) const {
+        return io_pages[addr / page_words];
+    }
+
+    /* Sends loads and stores of addr (in the I/O region) to device from now on, and makes its page an I/O page */
+    void attach(const std::uint16_t addr, Device &device) {
+        devices[addr - Memory::io_start] = &device;
+        io_pages[addr / page_words] = true;
+    }
+
+    /* The device attached at addr, or nullptr */
+    Device *device(const std::uint16_t addr) const {
+        return addr >= Memory::io_start ? devices[addr - Memory::io_start] : nullptr;
+    }
+
+    /* Stops the guest after every store to addr from now on (see Machine::write) */
+    void watch(const std::uint16_t addr) {
+        watched[addr] = true;
+        io_pages[addr / page_words] = true;
+    }
+
+    /* Removes the watchpoint at addr, its page goes back to RAM if nothing else is on it */
+    void unwatch(const std::uint16_t addr) {
+        watched[addr] = false;
+        const std::size_t first { addr / page_words * page_words };
+        bool io { false };
+        for (std::size_t word { first }; word < first + page_words; ++word) {
+            io = io || watched[word] || device(static_cast<std::uint16_t>(word));
+        }
+        io_pages[addr / page_words] = io;
+    }
+
+    bool watching(const std::uint16_t addr) const {
+        return watched[addr];
+    }
+
+private:
+    std::array<bool, page_count> io_pages {};
+    std::array<Device *, Memory::mem_amt - Memory::io_start> devices {};
+    std::bitset<Memory::mem_amt> watched {};
+};
+
+#endif //LC3VM_BUS_HPP
@@ -0,0 +1,180 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Counters.hpp"
+#include "Profile.hpp"
+
+#if LC3VM_COUNTERS
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct Counters::State {
+    Profile &profile;
+    std::array<int, Profile::HOST_EVENT_COUNT> fds;
+    std::array<Profile::HostEvent, Profile::HOST_EVENT_COUNT> order; /* The events as the group reads them, leader first */
+    std::size_t count {};
+    Profile::HostCounts last {};                                     /* What the group read at the last sample, in order */
+    struct sigaction previous {};
+};
+
+namespace {
+
+    struct Event {
+        Profile::HostEvent id;
+        std::uint32_t type;
+        std::uint64_t config;
+        std::uint64_t period; /* Between samples when the event leads */
+    };
+
+    // Leaders are tried in this order, about ten thousand samples a second
+    constexpr std::array<Event, Profile::HOST_EVENT_COUNT> events { {
+        { Profile::CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 250'000 },
+        { Profile::TASK_CLOCK, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, 100'000 },
+        { Profile::INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, 0 },
+        { Profile::BRANCH_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, 0 },
+        { Profile::L1D_MISSES, PERF_TYPE_HW_CACHE,
+          PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16, 0 },
+    } };
+
+    int open_event(const Event &event, const int group, const bool leader) {
+        perf_event_attr attr {};
+        attr.size = sizeof attr;
+        attr.type = event.type;
+        attr.config = event.config;
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        if (leader) {
+            attr.sample_period = event.period;
+            attr.disabled = 1;
+        }
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, PERF_FLAG_FD_CLOEXEC));
+    }
+
+    /* The running sampler, for the signal handler */
+    std::atomic<Counters::State *> sampling { nullptr };
+
+    /* Layout of a PERF_FORMAT_GROUP read */
+    struct GroupRead {
+        std::uint64_t count;
+        Profile::HostCounts values;
+    };
+
+    /* Charges what the group counted since the last sample to the instruction the guest is executing */
+    void sample(int) {
+        Counters::State *const state { sampling.load(std::memory_order_relaxed) };
+        if (!state) {
+            return;
+        }
+        const int saved { errno };
+        GroupRead group;
+        if (read(state->fds[0], &group, sizeof group) > 0) {
+            Profile &profile { state->profile };
+            const std::uint32_t running { profile.running.load(std::memory_order_relaxed) };
+            Profile::HostCounts &opcode { profile.host_opcodes[running >> 16] };
+            Profile::HostCounts &range { profile.host_ranges[(running & 0xFFFF) / Profile::range_size] };
+            for (std::size_t i {}; i < state->count && i < group.count; ++i) {
+                const std::uint64_t delta { group.values[i] - state->last[i] };
+                state->last[i] = group.values[i];
+                opcode[state->order[i]] += delta;
+                range[state->order[i]] += delta;
+            }
+            ++profile.host_samples;
+        }
+        errno = saved;
+    }
+
+}
+
+Counters::Sampler::Sampler(Profile &profile) : state { std::make_unique<State>(profile) } {
+    state->fds.fill(-1);
+
+    const Event *leader { nullptr };
+    for (std::size_t i {}; i < 2 && state->fds[0] < 0; ++i) {
+        state->fds[0] = open_event(events[i], -1, true);
+        leader = &events[i];
+    }
+    if (state->fds[0] < 0) {
+        return;
+    }
+    state->order[state->count++] = leader->id;
+    for (const Event &event : events) {
+        if (&event == leader) {
+            continue;
+        }
+        const int fd { open_event(event, state->fds[0], false) };
+        if (fd >= 0) {
+            state->fds[state->count] = fd;
+            state->order[state->count++] = event.id;
+        }
+    }
+    for (std::size_t i {}; i < state->count; ++i) {
+        profile.host_counted[state->order[i]] = true;
+    }
+    profile.host_leader = leader->id;
+    profile.host_period = leader->period;
+
+    // The leader's overflows raise SIGPROF on this thread
+    struct sigaction action {};
+    action.sa_handler = sample;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &state->previous);
+
+    const f_owner_ex owner { F_OWNER_TID, static_cast<pid_t>(syscall(SYS_gettid)) };
+    const int leader_fd { state->fds[0] };
+    fcntl(leader_fd, F_SETOWN_EX, &owner);
+    fcntl(leader_fd, F_SETSIG, SIGPROF);
+    fcntl(leader_fd, F_SETFL, fcntl(leader_fd, F_GETFL) | O_ASYNC);
+
+    sampling.store(state.get(), std::memory_order_relaxed);
+    ioctl(leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+Counters::Sampler::~Sampler() {
+    if (!running()) {
+        return;
+    }
+    ioctl(state->fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    sampling.store(nullptr, std::memory_order_relaxed);
+    sigaction(SIGPROF, &state->previous, nullptr);
+
+    // The totals include what ran after the last sample
+    GroupRead group;
+    if (read(state->fds[0], &group, sizeof group) > 0) {
+        for (std::size_t i {}; i < state->count && i < group.count; ++i) {
+            state->profile.host_totals[state->order[i]] = group.values[i];
+        }
+    }
+    for (std::size_t i { state->count }; i-- > 0;) {
+        close(state->fds[i]);
+    }
+}
+
+bool Counters::Sampler::running() const {
+    return state->fds[0] >= 0;
+}
+
+#else
+
+struct Counters::State {};
+
+Counters::Sampler::Sampler(Profile &) : state { std::make_unique<State>() } {}
+
+Counters::Sampler::~Sampler() = default;
+
+bool Counters::Sampler::running() const {
+    return false;
+}
+
+#endif
@@ -0,0 +1,58 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_COUNTERS_HPP
+#define LC3VM_COUNTERS_HPP
+#include <memory>
+
+/* Host counters are read with perf_event_open */
+#if defined(__linux__)
+#define LC3VM_COUNTERS 1
+#else
+#define LC3VM_COUNTERS 0
+#endif
+
+struct Profile;
+
+namespace Counters {
+
+    /* Whether host counters can be read on this platform */
+    constexpr bool supported() {
+        return LC3VM_COUNTERS;
+    }
+
+    struct State;
+
+    /*
+     * Counts host cycles, instructions, branch misses, L1d read misses and CPU time
+     * for the thread that makes it, as one perf_event_open group, until it is
+     * destroyed, and writes them into the profile's host counters.
+     *
+     * The group is sampled on its leader, cycles or CPU time when the host has no
+     * cycle counter, and each sample charges what the group counted since the last
+     * one to the instruction a profiled run (Interpreter::run(Machine &, Profile &))
+     * was executing, its opcode and its address range. Like the profile's own counts
+     * the sampled counts include the profiling, which costs every instruction about
+     * the same, so the opcodes still compare.
+     *
+     * Events the host cannot count are left out, there is only one sampler at a time.
+     */
+    class Sampler {
+    public:
+        explicit Sampler(Profile &);
+        ~Sampler();
+
+        Sampler(const Sampler &) = delete;
+        Sampler &operator=(const Sampler &) = delete;
+
+        /* Whether the counters are running, false if not even the leader could be opened */
+        bool running() const;
+
+    private:
+        std::unique_ptr<State> state;
+    };
+
+}
+
+#endif //LC3VM_COUNTERS_HPP
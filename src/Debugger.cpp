@@ -0,0 +1,231 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Debugger.hpp"
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include "Interpreter.hpp"
+#include "Machine.hpp"
+#include "Notation.hpp"
+#include "Opcodes.hpp"
+
+namespace {
+
+    using Notation::Hex;
+    using Notation::opcode_names;
+    using Notation::parse_number;
+
+    class Session {
+    public:
+        Session(Machine &m, std::ostream &out) : m { m }, out { out } {}
+
+        /* Runs one command line, returns false for quit */
+        bool command(const std::string &line);
+
+    private:
+        void resume(std::optional<std::uint64_t> steps);
+        void report(Interpreter::Stop stop);
+        void where() const;
+        void regs() const;
+        void examine(std::uint16_t addr, std::uint16_t count) const;
+        void info() const;
+
+        Machine &m;
+        std::ostream &out;
+
+        std::set<std::uint16_t> breakpoints;
+        std::map<std::uint16_t, std::uint16_t> watchpoints; /* The value each one had when it last stopped */
+        bool finished { false };                            /* The program halted or faulted, it cannot run again */
+    };
+
+    bool Session::command(const std::string &line) {
+        std::istringstream words { line };
+        std::string name, first, second;
+        words >> name >> first >> second;
+
+        const auto addr { parse_number<std::uint16_t>(first) };
+
+        if (name == "break" || name == "b") {
+            if (!addr) {
+                out << "Usage: break ADDR\n";
+                return true;
+            }
+            breakpoints.insert(*addr);
+            Interpreter::set_breakpoint(m, *addr);
+            out << "Breakpoint at " << Hex { *addr } << '\n';
+        } else if (name == "watch" || name == "w") {
+            if (!addr) {
+                out << "Usage: watch ADDR\n";
+                return true;
+            }
+            watchpoints[*addr] = m.mem[*addr];
+            m.bus.watch(*addr);
+            out << "Watchpoint at " << Hex { *addr } << '\n';
+        } else if (name == "delete" || name == "d") {
+            if (!addr) {
+                out << "Usage: delete ADDR\n";
+                return true;
+            }
+            if (breakpoints.erase(*addr)) {
+                Interpreter::clear_breakpoint(m, *addr);
+                out << "Deleted breakpoint at " << Hex { *addr } << '\n';
+            }
+            if (watchpoints.erase(*addr)) {
+                m.bus.unwatch(*addr);
+                out << "Deleted watchpoint at " << Hex { *addr } << '\n';
+            }
+        } else if (name == "continue" || name == "c") {
+            resume(std::nullopt);
+        } else if (name == "step" || name == "s") {
+            const auto steps { first.empty() ? 1 : parse_number<std::uint64_t>(first) };
+            if (!steps || *steps == 0) {
+                out << "Usage: step [N]\n";
+                return true;
+            }
+            resume(steps);
+        } else if (name == "regs" || name == "r") {
+            regs();
+        } else if (name == "x") {
+            const auto count { second.empty() ? 8 : parse_number<std::uint16_t>(second) };
+            if (!addr || !count) {
+                out << "Usage: x ADDR [N]\n";
+                return true;
+            }
+            examine(*addr, *count);
+        } else if (name == "info" || name == "i") {
+            info();
+        } else if (name == "quit" || name == "q") {
+            return false;
+        } else {
+            out << "Commands: break ADDR, watch ADDR, delete ADDR, continue, step [N], regs, x ADDR [N], info, quit\n";
+        }
+        return true;
+    }
+
+    void Session::resume(const std::optional<std::uint64_t> steps) {
+        if (finished) {
+            out << "The program is not running\n";
+            return;
+        }
+
+        // A store overwrites a breakpoint along with the instruction, so they are all set again before every run
+        const std::uint16_t pc { m.regs[Registers::PC] };
+        for (const std::uint16_t addr : breakpoints) {
+            Interpreter::set_breakpoint(m, addr);
+        }
+
+        // The breakpoint at PC is where the last run stopped, it is stepped over with the breakpoint cleared
+        std::uint64_t budget { steps.value_or(std::numeric_limits<std::uint64_t>::max()) };
+        if (breakpoints.contains(pc)) {
+            Interpreter::clear_breakpoint(m, pc);
+            std::uint64_t one { 1 };
+            const Interpreter::Stop stop { Interpreter::run(m, one) };
+            Interpreter::set_breakpoint(m, pc);
+            --budget;
+            if (stop != Interpreter::OUT_OF_BUDGET || budget == 0) {
+                report(stop);
+                return;
+            }
+        }
+
+        report(steps ? Interpreter::run(m, budget) : Interpreter::run(m));
+    }
+
+    void Session::report(const Interpreter::Stop stop) {
+        // Whatever the program printed comes before the reply
+        m.display.flush();
+
+        switch (stop) {
+            case Interpreter::HALTED:
+                finished = true;
+                out << "Halted\n";
+                return;
+            case Interpreter::FAULTED:
+                finished = true;
+                out << "Fault at ";
+                break;
+            case Interpreter::BREAKPOINT:
+                out << "Breakpoint at ";
+                break;
+            case Interpreter::WATCHPOINT: {
+                std::uint16_t &last { watchpoints[m.watch_hit] };
+                out << "Watchpoint " << Hex { m.watch_hit } << ": " << Hex { last } << " -> "
+                    << Hex { m.mem[m.watch_hit] } << ", stopped at ";
+                last = m.mem[m.watch_hit];
+                break;
+            }
+            case Interpreter::OUT_OF_BUDGET:
+            case Interpreter::PREEMPTED:
+                break;
+        }
+        where();
+    }
+
+    void Session::where() const {
+        const std::uint16_t pc { m.regs[Registers::PC] };
+        const std::uint16_t instr { m.mem[pc] };
+        out << Hex { pc } << ": " << Hex { instr } << ' ' << opcode_names[instr >> 12] << '\n';
+    }
+
+    void Session::regs() const {
+        for (std::size_t reg { Registers::R0 }; reg <= Registers::R7; ++reg) {
+            out << 'R' << reg << ' ' << Hex { m.regs[reg] } << (reg == Registers::R7 ? '\n' : ' ');
+        }
+
+        const std::uint16_t cond { m.regs[Registers::COND] };
+        out << "PC " << Hex { m.regs[Registers::PC] } << " COND "
+            << (cond & CondFlags::NEG ? "N" : "") << (cond & CondFlags::ZERO ? "Z" : "")
+            << (cond & CondFlags::POS ? "P" : "") << '\n';
+    }
+
+    void Session::examine(const std::uint16_t addr, const std::uint16_t count) const {
+        constexpr std::uint16_t per_line { 8 };
+        for (std::uint16_t i {}; i < count; ++i) {
+            const auto word { static_cast<std::uint16_t>(addr + i) };
+            if (i % per_line == 0) {
+                out << Hex { word } << ':';
+            }
+            out << ' ' << Hex { m.mem[word] };
+            if (i % per_line == per_line - 1 || i == count - 1) {
+                out << '\n';
+            }
+        }
+    }
+
+    void Session::info() const {
+        for (const std::uint16_t addr : breakpoints) {
+            out << "Breakpoint at " << Hex { addr } << '\n';
+        }
+        for (const auto &[addr, val] : watchpoints) {
+            out << "Watchpoint at " << Hex { addr } << " = " << Hex { val } << '\n';
+        }
+    }
+
+}
+
+void Debugger::run(Machine &m, std::istream &commands, std::ostream &replies) {
+    Session session { m, replies };
+    std::string line, last;
+    while (true) {
+        replies << "(lc3) " << std::flush;
+        if (!std::getline(commands, line)) {
+            replies << '\n';
+            return;
+        }
+        if (line.find_first_not_of(" \t") == std::string::npos) {
+            line = last;
+        }
+        if (!session.command(line)) {
+            return;
+        }
+        last = line;
+    }
+}
@@ -0,0 +1,35 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_DEBUGGER_HPP
+#define LC3VM_DEBUGGER_HPP
+#include <iostream>
+
+class Machine;
+
+namespace Debugger {
+
+    /*
+     * An interactive debugger for the interpreter. It reads one command per line from
+     * commands and answers on replies, until quit or the end of commands:
+     *
+     *   break ADDR   (b)  stop before the instruction at ADDR runs
+     *   watch ADDR   (w)  stop after every store to ADDR
+     *   delete ADDR  (d)  remove the breakpoint and watchpoint at ADDR
+     *   continue     (c)  run until a breakpoint, watchpoint, HALT or fault
+     *   step [N]     (s)  run N instructions, 1 by default
+     *   regs         (r)  print the registers
+     *   x ADDR [N]        print N words of memory starting at ADDR, 8 by default
+     *   info         (i)  list breakpoints and watchpoints
+     *   quit         (q)
+     *
+     * An empty line repeats the last command. Breakpoints are the interpreter's
+     * (see Interpreter::set_breakpoint) and watchpoints the bus's (see Bus::watch),
+     * so a run without any goes as fast as one without the debugger.
+     */
+    void run(Machine &, std::istream &commands, std::ostream &replies);
+
+}
+
+#endif //LC3VM_DEBUGGER_HPP
@@ -0,0 +1,200 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Decode.hpp"
+#include "Machine.hpp"
+#include "Memory.hpp"
+#include "Opcodes.hpp"
+#include "Registers.hpp"
+#include "Trap.hpp"
+
+namespace {
+
+    /*
+     * Encoding: https://www.jmeiners.com/lc3-vm/supplies/lc3-isa.pdf
+     * Splits the instruction into the handler that executes it and its operands.
+     * Register fields are always extracted, the immediate is sign extended to
+     * whichever width the opcode uses.
+     */
+    constexpr Decode::Instr decode_word(const std::uint16_t instr) {
+        using namespace Decode;
+
+        Instr decoded {
+            UNDECODED,
+            static_cast<std::uint8_t>(instr >> 9 & 0x7),
+            static_cast<std::uint8_t>(instr >> 6 & 0x7),
+            static_cast<std::uint8_t>(instr & 0x7),
+            0,
+            instr,
+        };
+
+        const bool imm_mode ( instr >> 5 & 0x1 );
+
+        switch (instr >> 12) {
+            case Opcodes::BR:
+                decoded.handler = BR;
+                decoded.imm = Opcodes::sign_extend(instr & 0x1FF, 9);
+                break;
+            case Opcodes::ADD:
+                decoded.handler = imm_mode ? ADD_IMM : ADD_REG;
+                decoded.imm = Opcodes::sign_extend(instr & 0x1F, 5);
+                break;
+            case Opcodes::LD:
+                decoded.handler = LD;
+                decoded.imm = Opcodes::sign_extend(instr & 0x1FF, 9);
+                break;
+            case Opcodes::ST:
+                decoded.handler = ST;
+                decoded.imm = Opcodes::sign_extend(instr & 0x1FF, 9);
+                break;
+            case Opcodes::JSR:
+                decoded.handler = instr >> 11 & 0x1 ? JSR : JSRR;
+                decoded.imm = Opcodes::sign_extend(instr & 0x7FF, 11);
+                break;
+            case Opcodes::AND:
+                decoded.handler = imm_mode ? AND_IMM : AND_REG;
+                decoded.imm = Opcodes::sign_extend(instr & 0x1F, 5);
+                break;
+            case Opcodes::LDR:
+                decoded.handler = LDR;
+                decoded.imm = Opcodes::sign_extend(instr & 0x3F, 6);
+                break;
+            case Opcodes::STR:
+                decoded.handler = STR;
+                decoded.imm = Opcodes::sign_extend(instr & 0x3F, 6);
+                break;
+            case Opcodes::RTI:
+                decoded.handler = RTI;
+                break;
+            case Opcodes::NOT:
+                decoded.handler = NOT;
+                break;
+            case Opcodes::LDI:
+                decoded.handler = LDI;
+                decoded.imm = Opcodes::sign_extend(instr & 0x1FF, 9);
+                break;
+            case Opcodes::STI:
+                decoded.handler = STI;
+                decoded.imm = Opcodes::sign_extend(instr & 0x1FF, 9);
+                break;
+            case Opcodes::JMP:
+                decoded.handler = JMP;
+                break;
+            case Opcodes::RES:
+                decoded.handler = RES;
+                break;
+            case Opcodes::LEA:
+                decoded.handler = LEA;
+                decoded.imm = Opcodes::sign_extend(instr & 0x1FF, 9);
+                break;
+            case Opcodes::TRAP:
+                // Unknown vectors panic, the same as the reserved opcode
+                if ((instr & 0xFF) == Trap::HALT) {
+                    decoded.handler = HALT;
+                } else if ((instr & 0xFF) >= Trap::GETC && (instr & 0xFF) <= Trap::PUTSP) {
+                    decoded.handler = TRAP;
+                } else {
+                    decoded.handler = RES;
+                }
+                decoded.imm = instr & 0xFF;
+                break;
+            default:
+                break;
+        }
+
+        return decoded;
+    }
+
+}
+
+constexpr std::array<Decode::Instr, Memory::mem_amt> Decode::table { [] {
+    std::array<Instr, Memory::mem_amt> table {};
+    for (std::size_t word {}; word < table.size(); ++word) {
+        table[word] = decode_word(static_cast<std::uint16_t>(word));
+    }
+    return table;
+}() };
+
+void Decode::predecode(Machine &m, const std::uint16_t addr, const std::size_t count) {
+    for (std::size_t i {}; i < count && addr + i < Memory::mem_amt; ++i) {
+        m.decoded[addr + i] = decode(m.mem[addr + i]);
+    }
+
+    // Sequences can start up to two words before the new code
+    const std::uint16_t start ( addr < 2 ? 0 : addr - 2 );
+    fuse(m, start, count + (addr - start));
+}
+
+namespace {
+
+    /* The handler an instruction has on its own, for a fused first instruction */
+    std::uint8_t plain(const std::uint8_t handler) {
+        switch (handler) {
+            case Decode::ADD_IMM_BR:
+                return Decode::ADD_IMM;
+            case Decode::LDR_ADD_STR:
+                return Decode::LDR;
+            case Decode::AND_ZERO_ADD:
+                return Decode::AND_IMM;
+            case Decode::LEA_PUTS:
+                return Decode::LEA;
+            default:
+                return handler;
+        }
+    }
+
+    /* The superinstruction starting with first, second and third, or first's own handler if there is none */
+    std::uint8_t fused(const Decode::Instr &first, const Decode::Instr &second, const Decode::Instr &third) {
+        const std::uint8_t next { plain(second.handler) };
+        const std::uint8_t after { plain(third.handler) };
+
+        switch (plain(first.handler)) {
+            case Decode::ADD_IMM:
+                if (next == Decode::BR) {
+                    return Decode::ADD_IMM_BR;
+                }
+                break;
+            case Decode::LDR:
+                // The base register must survive the load for the store to hit the same word
+                if (next == Decode::ADD_IMM && after == Decode::STR && first.dr != first.sr1
+                    && second.dr == first.dr && second.sr1 == first.dr
+                    && third.dr == first.dr && third.sr1 == first.sr1 && third.imm == first.imm) {
+                    return Decode::LDR_ADD_STR;
+                }
+                break;
+            case Decode::AND_IMM:
+                if (first.imm == 0 && next == Decode::ADD_IMM && second.sr1 == first.dr) {
+                    return Decode::AND_ZERO_ADD;
+                }
+                break;
+            case Decode::LEA:
+                if (first.dr == Registers::R0 && next == Decode::TRAP && second.imm == Trap::PUTS) {
+                    return Decode::LEA_PUTS;
+                }
+                break;
+            default:
+                break;
+        }
+        return plain(first.handler);
+    }
+
+}
+
+void Decode::fuse(Machine &m, const std::uint16_t addr, const std::size_t count) {
+    // Sequences are three words at most and may not wrap around memory
+    for (std::size_t i { addr }; i < addr + count && i + 2 < Memory::mem_amt; ++i) {
+        Instr &first { m.decoded[i] };
+        if (!fusable(first.handler)) {
+            continue;
+        }
+
+        const Instr &second { m.decoded[i + 1] };
+        const Instr &third { m.decoded[i + 2] };
+        if (!fusable(second.handler)) {
+            first.handler = plain(first.handler);
+            continue;
+        }
+        first.handler = fused(first, second, fusable(third.handler) ? third : Instr {});
+    }
+}
@@ -0,0 +1,91 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_DECODE_HPP
+#define LC3VM_DECODE_HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "Memory.hpp"
+
+class Machine;
+
+namespace Decode {
+
+    /* Handlers an instruction can decode to (opcodes with two modes get one handler per mode) */
+    enum : std::uint8_t {
+        UNDECODED, /* Not decoded yet, or the word was overwritten since */
+        BREAK,     /* Breakpoint, never produced by decode (see Interpreter::set_breakpoint) */
+        BR,        /* Branch */
+        ADD_REG,   /* Add register */
+        ADD_IMM,   /* Add imm5 */
+        LD,        /* Load */
+        ST,        /* Store */
+        JSR,       /* Jump to subroutine (PC offset) */
+        JSRR,      /* Jump to subroutine (base register) */
+        AND_REG,   /* Bitwise and register */
+        AND_IMM,   /* Bitwise and imm5 */
+        LDR,       /* Load register */
+        STR,       /* Store register */
+        RTI,       /* Unused */
+        NOT,       /* Bitwise not */
+        LDI,       /* Load indirect */
+        STI,       /* Store indirect */
+        JMP,       /* Jump */
+        RES,       /* Reserved (unused), also TRAPs with an unknown vector */
+        LEA,       /* Load effective address */
+        TRAP,      /* Execute trap */
+        HALT,      /* Halt trap */
+
+        /* Superinstructions, a fused first instruction executes the ones after it too (see fuse) */
+        ADD_IMM_BR,   /* ADD DR, SR1, #imm5 then BR, a loop counter */
+        LDR_ADD_STR,  /* LDR DR, BaseR, #o then ADD DR, DR, #imm5 then STR DR, BaseR, #o, read-modify-write */
+        AND_ZERO_ADD, /* AND DR, SR1, #0 then ADD DR2, DR, #imm5, a constant load */
+        LEA_PUTS,     /* LEA R0, label then TRAP PUTS */
+
+        COUNT,     /* Count of all handlers */
+    };
+
+    /* Whether an instruction can be executed as part of a superinstruction, i.e. it is decoded and not a breakpoint */
+    constexpr bool fusable(const std::uint8_t handler) {
+        return handler > BREAK;
+    }
+
+    /* An instruction with all of its fields already extracted */
+    struct Instr {
+        std::uint8_t handler; /* One of the handlers above */
+        std::uint8_t dr;      /* Bits 9-11 (DR, SR of the stores or the nzp flags of BR) */
+        std::uint8_t sr1;     /* Bits 6-8 (SR1 or BaseR) */
+        std::uint8_t sr2;     /* Bits 0-2 (SR2) */
+        std::uint16_t imm;    /* Sign extended immediate / offset, or the trap vector */
+        std::uint16_t word;   /* The raw instruction */
+    };
+
+    /*
+     * Every instruction word decoded at compile time, indexed by the word itself,
+     * so decoding is one load with no branches on the opcode or mode bits.
+     */
+    extern const std::array<Instr, Memory::mem_amt> table;
+
+    inline Instr decode(const std::uint16_t instr) {
+        return table[instr];
+    }
+
+    /* Decodes count words of the machine's memory starting at addr into Machine::decoded, then fuses them */
+    void predecode(Machine &, std::uint16_t addr, std::size_t count);
+
+    /*
+     * Looks for superinstructions starting anywhere in addr to addr + count and
+     * turns their first instruction into the fused handler, or back into its plain
+     * handler when the sequence no longer matches. Only the first instruction
+     * changes, the others stay decoded on their own so jumping into the middle of
+     * a sequence still works. A fused handler checks the words after it are still
+     * fusable when it runs, and redecoding any of them calls fuse again for the
+     * two words before it, so a fused handler never runs a stale sequence.
+     */
+    void fuse(Machine &, std::uint16_t addr, std::size_t count);
+
+}
+
+#endif //LC3VM_DECODE_HPP
@@ -0,0 +1,93 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Devices.hpp"
+#include "Machine.hpp"
+#include "Trace.hpp"
+
+std::uint16_t KeyboardPort::read(Machine &m, const std::uint16_t addr) {
+    if (addr == Memory::KBSR) {
+        m.display.input_requested();
+        const auto ready = [&] {
+            return m.keyboard.ready() || (busy_waiting() && m.keyboard.wait_for(idle_wait));
+        };
+        const auto get = [&] {
+            return m.keyboard.get();
+        };
+        if (m.trace ? m.trace->flag(ready) : ready()) {
+            unready = 0;
+            m.write_ram(Memory::KBSR, 1 << 15);
+            m.write_ram(Memory::KBDR, m.trace ? m.trace->key(get) : get());
+        } else {
+            m.write_ram(Memory::KBSR, 0);
+        }
+    }
+    return m.mem[addr];
+}
+
+bool KeyboardPort::busy_waiting() {
+    if (unready++ == 0) {
+        unready_since = std::chrono::steady_clock::now();
+        return false;
+    }
+    if (unready < idle_polls) {
+        return false;
+    }
+    // Either way counting starts over, after a wait that timed out too, so a program that stops polling stops waiting
+    unready = 0;
+    return std::chrono::steady_clock::now() - unready_since <= spin_window;
+}
+
+void KeyboardPort::write(Machine &m, const std::uint16_t addr, const std::uint16_t val) {
+    m.write_ram(addr, val);
+}
+
+std::uint16_t DisplayPort::read(Machine &m, const std::uint16_t addr) {
+    if (addr == Memory::DSR) {
+        m.write_ram(Memory::DSR, 1 << 15);
+    }
+    return m.mem[addr];
+}
+
+void DisplayPort::write(Machine &m, const std::uint16_t addr, const std::uint16_t val) {
+    m.write_ram(addr, val);
+    if (addr == Memory::DDR) {
+        m.display.put(static_cast<char>(val & 0xFF));
+    }
+}
+
+std::uint16_t Timer::read(Machine &m, const std::uint16_t addr) {
+    if (addr == Memory::TMR) {
+        const auto expired = [&] {
+            const std::chrono::milliseconds interval { m.mem[Memory::TMI] };
+            const auto now { std::chrono::steady_clock::now() };
+            if (interval.count() == 0 || now - start < interval) {
+                return false;
+            }
+            start = now;
+            return true;
+        };
+        m.write_ram(Memory::TMR, (m.trace ? m.trace->flag(expired) : expired()) << 15);
+    }
+    return m.mem[addr];
+}
+
+void Timer::write(Machine &m, const std::uint16_t addr, const std::uint16_t val) {
+    m.write_ram(addr, val);
+    if (addr == Memory::TMI) {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+std::uint16_t MachineControl::read(Machine &, const std::uint16_t) {
+    return value;
+}
+
+void MachineControl::write(Machine &m, const std::uint16_t addr, const std::uint16_t val) {
+    value = val;
+    m.write_ram(addr, val);
+    if (!running()) {
+        m.display.halted();
+    }
+}
@@ -0,0 +1,103 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_DEVICES_HPP
+#define LC3VM_DEVICES_HPP
+#include <chrono>
+#include <cstdint>
+#include "Bus.hpp"
+
+/*
+ * The standard LC-3 devices as seen from the bus. Status registers have bit 15
+ * set when the device is ready.
+ */
+
+/*
+ * KBSR: a read checks for a key, and if there is one latches it into KBDR (which
+ * is plain memory).
+ *
+ * Programs wait for input by reading KBSR in a loop. Once idle_polls reads in a
+ * row found no key, and came faster than spin_window allows for anything but
+ * such a loop, the guest is busy waiting and the last read blocks the host thread
+ * until a key arrives, for at most idle_wait so loops that also watch the timer
+ * keep running. A spinning guest then spends almost all its time blocked, and it
+ * still sees KBSR clear until there is a key.
+ */
+class KeyboardPort : public Device {
+public:
+    std::uint16_t read(Machine &m, std::uint16_t addr) override;
+    void write(Machine &m, std::uint16_t addr, std::uint16_t val) override;
+
+private:
+    static constexpr std::uint32_t idle_polls { 1024 };
+    static constexpr std::chrono::microseconds spin_window { 1000 };
+    static constexpr std::chrono::microseconds idle_wait { 10'000 };
+
+    /* Whether this unready read is part of a busy wait */
+    bool busy_waiting();
+
+    std::uint32_t unready {}; /* Reads without a key since the last one with a key */
+    std::chrono::steady_clock::time_point unready_since;
+};
+
+/* DSR and DDR: the display is always ready, the low byte of a DDR store is printed */
+class DisplayPort : public Device {
+public:
+    std::uint16_t read(Machine &m, std::uint16_t addr) override;
+    void write(Machine &m, std::uint16_t addr, std::uint16_t val) override;
+};
+
+/*
+ * TMR and TMI: TMI is an interval in milliseconds (0 stops the timer) and a TMR
+ * read has bit 15 set if an interval has passed since the last TMR read that had it
+ * set, or since TMI was written.
+ */
+class Timer : public Device {
+public:
+    std::uint16_t read(Machine &m, std::uint16_t addr) override;
+    void write(Machine &m, std::uint16_t addr, std::uint16_t val) override;
+
+    /* How far into the current interval the timer is, which is what a snapshot saves */
+    std::chrono::milliseconds elapsed() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    }
+
+    /* Continues an interval that was elapsed into when it was saved */
+    void resume(const std::chrono::milliseconds elapsed) {
+        start = std::chrono::steady_clock::now() - elapsed;
+    }
+
+private:
+    std::chrono::steady_clock::time_point start { std::chrono::steady_clock::now() };
+};
+
+/* MCR: bit 15 is the clock enable, clearing it stops the machine like HALT does */
+class MachineControl : public Device {
+public:
+    std::uint16_t read(Machine &m, std::uint16_t addr) override;
+    void write(Machine &m, std::uint16_t addr, std::uint16_t val) override;
+
+    bool running() const {
+        return value >> 15;
+    }
+
+    /* Sets the clock enable bit again, for reset */
+    void power_on() {
+        value |= 1 << 15;
+    }
+
+    /* The whole register, for snapshots (a read through the bus returns the same) */
+    std::uint16_t get() const {
+        return value;
+    }
+
+    void set(const std::uint16_t val) {
+        value = val;
+    }
+
+private:
+    std::uint16_t value { 1 << 15 };
+};
+
+#endif //LC3VM_DEVICES_HPP
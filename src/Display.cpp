@@ -0,0 +1,42 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Display.hpp"
+#include <algorithm>
+#include <cstring>
+
+void Display::set_policy(const std::uint8_t policy, const std::size_t every) {
+    flush();
+    this->policy = policy;
+    this->every = std::clamp<std::size_t>(every, 1, capacity);
+}
+
+void Display::write(const char *data, std::size_t count) {
+    const bool newline { policy & ON_NEWLINE && std::memchr(data, '\n', count) };
+
+    while (count > 0) {
+        const std::size_t chunk { std::min(count, every - size) };
+        std::memcpy(buffer.data() + size, data, chunk);
+        size += chunk;
+        data += chunk;
+        count -= chunk;
+
+        if (size >= every) {
+            flush();
+        }
+    }
+
+    if (newline) {
+        flush();
+    }
+}
+
+void Display::flush() {
+    if (size == 0) {
+        return;
+    }
+    sink.write(buffer.data(), static_cast<std::streamsize>(size));
+    sink.flush();
+    size = 0;
+}
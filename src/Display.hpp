@@ -0,0 +1,67 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_DISPLAY_HPP
+#define LC3VM_DISPLAY_HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+/*
+ * The display device. Output is collected in a buffer and handed to the sink
+ * stream in large writes, when the flush policy says so or the buffer is full.
+ */
+class Display {
+public:
+    /* When to flush besides a full buffer, combine with | */
+    enum Policy : std::uint8_t {
+        ON_NEWLINE = 1 << 0, /* After output containing '\n' */
+        ON_INPUT   = 1 << 1, /* Before the guest reads the keyboard, so prompts are visible */
+        ON_HALT    = 1 << 2, /* When the program halts */
+    };
+
+    static constexpr std::size_t capacity { 1 << 16 };
+
+    explicit Display(std::ostream &sink) : sink { sink } {}
+    ~Display() { flush(); }
+
+    Display(const Display &) = delete;
+    Display &operator=(const Display &) = delete;
+
+    /* policy is a combination of Policy flags, every flushes once that many bytes are buffered (at most capacity) */
+    void set_policy(std::uint8_t policy, std::size_t every = capacity);
+
+    void put(const char c) {
+        buffer[size++] = c;
+        if (size >= every || (c == '\n' && policy & ON_NEWLINE)) {
+            flush();
+        }
+    }
+
+    void write(const char *data, std::size_t count);
+
+    void flush();
+
+    void input_requested() {
+        if (policy & ON_INPUT) {
+            flush();
+        }
+    }
+
+    void halted() {
+        if (policy & ON_HALT) {
+            flush();
+        }
+    }
+
+private:
+    std::ostream &sink;
+    std::uint8_t policy { ON_NEWLINE | ON_INPUT | ON_HALT };
+    std::size_t every { capacity };
+    std::size_t size {};
+    std::array<char, capacity> buffer;
+};
+
+#endif //LC3VM_DISPLAY_HPP
@@ -0,0 +1,207 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "ForkServer.hpp"
+#include "Machine.hpp"
+
+#if LC3VM_FORK_SERVER
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include "Interpreter.hpp"
+
+namespace {
+
+    /* How long the server waits before accepting again when it ran out of descriptors or memory */
+    constexpr std::chrono::milliseconds accept_backoff { 100 };
+
+    /* Binds a Unix socket at path, replacing a socket left there by an earlier server but no other file */
+    int listen_at(const char *const path) {
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        if (std::strlen(path) >= sizeof address.sun_path) {
+            return -1;
+        }
+        std::strcpy(address.sun_path, path);
+
+        struct stat existing {};
+        if (lstat(path, &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+            unlink(path);
+        }
+
+        const int listener { socket(AF_UNIX, SOCK_STREAM, 0) };
+        if (listener < 0) {
+            return -1;
+        }
+        if (bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof address) != 0
+            || listen(listener, SOMAXCONN) != 0) {
+            close(listener);
+            return -1;
+        }
+        return listener;
+    }
+
+    /* The descriptors a request carries, -1 if absent */
+    struct Request {
+        int in { -1 };
+        int out { -1 };
+    };
+
+    /* Reads a request from the connection, false if it carried no descriptor */
+    bool receive(const int connection, Request &request) {
+        char byte;
+        iovec data { &byte, 1 };
+        alignas(cmsghdr) std::array<char, CMSG_SPACE(2 * sizeof(int))> control;
+        msghdr message {};
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+        message.msg_control = control.data();
+        message.msg_controllen = control.size();
+
+        ssize_t count;
+        while ((count = recvmsg(connection, &message, 0)) < 0 && errno == EINTR) {}
+        if (count <= 0) {
+            return false;
+        }
+
+        for (cmsghdr *header { CMSG_FIRSTHDR(&message) }; header; header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+                continue;
+            }
+            const std::size_t fds { (header->cmsg_len - CMSG_LEN(0)) / sizeof(int) };
+            for (std::size_t i {}; i < fds; ++i) {
+                int fd;
+                std::memcpy(&fd, CMSG_DATA(header) + i * sizeof(int), sizeof fd);
+                // Anything past the two descriptors a request has is not kept
+                if (request.in < 0) {
+                    request.in = fd;
+                } else if (request.out < 0) {
+                    request.out = fd;
+                } else {
+                    close(fd);
+                }
+            }
+        }
+        if (request.in >= 0 && request.out < 0) {
+            request.out = request.in;
+        }
+        return request.in >= 0;
+    }
+
+    void send_all(const int fd, const void *const data, const std::size_t size) {
+        const auto bytes { static_cast<const char *>(data) };
+        for (std::size_t sent {}; sent < size;) {
+            const ssize_t count { write(fd, bytes + sent, size - sent) };
+            if (count < 0 && errno != EINTR) {
+                return;
+            }
+            sent += count > 0 ? static_cast<std::size_t>(count) : 0;
+        }
+    }
+
+    /* The child's side of a connection, it never returns */
+    [[noreturn]] void run_child(Machine &m, const int listener, const int connection) {
+        std::signal(SIGCHLD, SIG_DFL);
+        close(listener);
+
+        Request request;
+        if (!receive(connection, request)) {
+            _exit(1);
+        }
+
+        dup2(request.in, STDIN_FILENO);
+        dup2(request.out, STDOUT_FILENO);
+        if (request.in > STDOUT_FILENO) {
+            close(request.in);
+        }
+        if (request.out > STDOUT_FILENO && request.out != request.in) {
+            close(request.out);
+        }
+        // The server's stdin ended during the run up to start_at
+        std::clearerr(stdin);
+        std::cin.clear();
+
+        const std::int32_t pid { getpid() };
+        send_all(connection, &pid, sizeof pid);
+
+        const Interpreter::Stop stop { Interpreter::run(m) };
+        m.display.flush();
+        const char status { stop == Interpreter::FAULTED };
+        send_all(connection, &status, 1);
+        if (stop == Interpreter::FAULTED) {
+            Interpreter::panic(m);
+        }
+        std::cout.flush();
+        _exit(0);
+    }
+
+}
+
+ForkServer::Failure ForkServer::serve(Machine &m, const Options &options) {
+    const int nothing { open("/dev/null", O_RDONLY) };
+    if (nothing >= 0) {
+        dup2(nothing, STDIN_FILENO);
+        close(nothing);
+    }
+
+    if (options.start_at) {
+        Interpreter::set_breakpoint(m, *options.start_at);
+        const Interpreter::Stop stop { Interpreter::run(m) };
+        Interpreter::clear_breakpoint(m, *options.start_at);
+        if (stop == Interpreter::FAULTED) {
+            Interpreter::panic(m);
+        }
+        if (stop == Interpreter::HALTED) {
+            return HALTED_BEFORE_START;
+        }
+    }
+
+    const int listener { listen_at(options.path) };
+    if (listener < 0) {
+        return LISTEN_FAILED;
+    }
+
+    // Children are never waited for, they are reaped as they exit
+    std::signal(SIGCHLD, SIG_IGN);
+    std::cout.flush();
+
+    while (true) {
+        const int connection { accept(listener, nullptr, nullptr) };
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            // Descriptors and memory come back as runs exit, anything else will not go away
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                std::this_thread::sleep_for(accept_backoff);
+                continue;
+            }
+            close(listener);
+            return ACCEPT_FAILED;
+        }
+
+        // The request is read in the child, so a client that never sends one only holds up its own run
+        if (fork() == 0) {
+            run_child(m, listener, connection);
+        }
+        close(connection);
+    }
+}
+
+#else
+
+ForkServer::Failure ForkServer::serve(Machine &, const Options &) {
+    return LISTEN_FAILED;
+}
+
+#endif
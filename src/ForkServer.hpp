@@ -0,0 +1,60 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_FORK_SERVER_HPP
+#define LC3VM_FORK_SERVER_HPP
+#include <cstdint>
+#include <optional>
+
+/* The fork server forks a process per run and takes its descriptors over a Unix socket */
+#if defined(__unix__) || defined(__APPLE__)
+#define LC3VM_FORK_SERVER 1
+#else
+#define LC3VM_FORK_SERVER 0
+#endif
+
+class Machine;
+
+namespace ForkServer {
+
+    /* Whether the fork server can run on this platform */
+    constexpr bool supported() {
+        return LC3VM_FORK_SERVER;
+    }
+
+    struct Options {
+        const char *path;                        /* Where the Unix socket is created */
+        std::optional<std::uint16_t> start_at;   /* Runs the machine up to this PC before serving */
+    };
+
+    enum Failure {
+        LISTEN_FAILED,
+        ACCEPT_FAILED,       /* Accepting a connection failed with an error that does not go away */
+        HALTED_BEFORE_START, /* The program halted before it reached start_at */
+    };
+
+    /*
+     * Serves runs of a machine that is loaded once. m has to read std::cin as a
+     * script and write std::cout. The server itself reads no input: its stdin is
+     * pointed at /dev/null, so the run up to start_at sees the end of the input.
+     *
+     * A client connects to the socket and sends at least one byte, with the run's
+     * input and output descriptors attached as SCM_RIGHTS (a single descriptor is
+     * used for both). The server forks for every connection, and the child reads
+     * the request, points stdin and stdout at its descriptors and runs m to HALT.
+     * A connection that closes without a request only ends its child. The child starts with the server's memory, registers
+     * and decoded instructions through copy-on-write pages, so no image is read
+     * and nothing is decoded again. On the connection the child sends its pid, a
+     * native int32, and once the program ended one byte: 0 if it halted, 1 if it
+     * faulted. A faulted child then panics like any run. The connection closes
+     * when the child exits, so a client can time out a run by killing the pid.
+     *
+     * Serves until the process ends or accepting fails for good, a fault before
+     * start_at panics.
+     */
+    Failure serve(Machine &m, const Options &options);
+
+}
+
+#endif //LC3VM_FORK_SERVER_HPP
@@ -0,0 +1,288 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Host.hpp"
+#include "Machine.hpp"
+
+#if LC3VM_HOST
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "Interpreter.hpp"
+
+namespace {
+
+    /* How long a guest runs before the other ready guests get their turn */
+    constexpr std::chrono::microseconds slice { 2000 };
+
+    /* A guest's coroutine. It starts suspended until its loop resumes it and frees itself when it is done */
+    struct Task {
+        struct promise_type {
+            Task get_return_object() {
+                return Task { std::coroutine_handle<promise_type>::from_promise(*this) };
+            }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        std::coroutine_handle<> handle;
+    };
+
+    /*
+     * One worker's event loop. A guest waiting on its socket is parked in epoll, with
+     * the socket registered one shot and the guest's handle as the event's data, and
+     * guests that can run wait in ready. A guest stays on the worker that accepted
+     * its connection, so nothing is shared between workers but the listener.
+     */
+    class Loop {
+    public:
+        Loop() : epoll { epoll_create1(EPOLL_CLOEXEC) } {}
+        ~Loop() {
+            if (epoll >= 0) {
+                close(epoll);
+            }
+        }
+
+        Loop(const Loop &) = delete;
+        Loop &operator=(const Loop &) = delete;
+
+        /* Every worker waits on the listener, EPOLLEXCLUSIVE wakes one of them per connection */
+        bool listen(const int listener) {
+            epoll_event event { EPOLLIN | EPOLLEXCLUSIVE, { .ptr = nullptr } };
+            return epoll >= 0 && epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event) == 0;
+        }
+
+        /* Resumes the guest once its socket fd has one of events, or an error or hangup */
+        auto wait(const int fd, const std::uint32_t events) {
+            struct Awaiter {
+                Loop &loop;
+                int fd;
+                std::uint32_t events;
+
+                bool await_ready() const noexcept {
+                    return false;
+                }
+
+                // A socket is added the first time its guest waits on it, if that fails the guest goes on and meets the error
+                bool await_suspend(const std::coroutine_handle<> guest) const {
+                    epoll_event event { events | EPOLLONESHOT, { .ptr = guest.address() } };
+                    return epoll_ctl(loop.epoll, EPOLL_CTL_MOD, fd, &event) == 0
+                        || (errno == ENOENT && epoll_ctl(loop.epoll, EPOLL_CTL_ADD, fd, &event) == 0);
+                }
+
+                void await_resume() const noexcept {}
+            };
+            return Awaiter { *this, fd, events };
+        }
+
+        /* Puts the guest behind the other ready guests, after the loop had another look at epoll */
+        auto yield() {
+            struct Awaiter {
+                Loop &loop;
+
+                bool await_ready() const noexcept {
+                    return false;
+                }
+
+                void await_suspend(const std::coroutine_handle<> guest) const {
+                    loop.ready.push_back(guest);
+                }
+
+                void await_resume() const noexcept {}
+            };
+            return Awaiter { *this };
+        }
+
+        /* Accepts connections and runs their guests, forever */
+        void run(int listener, const Machine &start);
+
+    private:
+        int epoll;
+        std::deque<std::coroutine_handle<>> ready;
+    };
+
+    /* Closes the connection when its guest is done, which also takes it out of epoll */
+    struct Socket {
+        int fd;
+
+        ~Socket() {
+            close(fd);
+        }
+    };
+
+    enum class Io {
+        DONE,
+        WAIT,   /* The socket would block */
+        CLOSED, /* The connection is gone */
+    };
+
+    /* Sends as much of output as the socket takes, sent counts the bytes sent so far */
+    Io send_some(const int fd, const std::string_view output, std::size_t &sent) {
+        while (sent < output.size()) {
+            const ssize_t count { send(fd, output.data() + sent, output.size() - sent, MSG_NOSIGNAL) };
+            if (count >= 0) {
+                sent += static_cast<std::size_t>(count);
+            } else if (errno != EINTR) {
+                return errno == EAGAIN || errno == EWOULDBLOCK ? Io::WAIT : Io::CLOSED;
+            }
+        }
+        return Io::DONE;
+    }
+
+    /* Feeds what arrived on the socket to the keyboard, a connection that stopped sending ends the input */
+    Io receive(const int fd, Keyboard &keyboard) {
+        std::array<char, 4096> keys;
+        while (true) {
+            const ssize_t count { recv(fd, keys.data(), keys.size(), 0) };
+            if (count > 0) {
+                keyboard.feed(keys.data(), static_cast<std::size_t>(count));
+                return Io::DONE;
+            }
+            if (count == 0) {
+                keyboard.close();
+                return Io::DONE;
+            }
+            if (errno != EINTR) {
+                return errno == EAGAIN || errno == EWOULDBLOCK ? Io::WAIT : Io::CLOSED;
+            }
+        }
+    }
+
+    Task guest(Loop &loop, const int fd, const Machine &start) {
+        const Socket socket { fd };
+
+        // The keyboard is fed from the socket, the stream is never read
+        std::istringstream unused;
+        std::ostringstream out;
+        const auto m { std::make_unique<Machine>(unused, out, Keyboard::HOSTED) };
+        m->display.set_policy(Display::ON_HALT);
+        m->mem = start.mem;
+        m->regs = start.regs;
+
+        std::uint64_t executed {};
+        while (true) {
+            const Interpreter::Quota quota {
+                std::numeric_limits<std::uint64_t>::max(), std::chrono::steady_clock::now() + slice,
+            };
+            const Interpreter::Stop stop { Interpreter::run(*m, quota, executed) };
+            if (stop == Interpreter::FAULTED) {
+                // There is nobody to panic to, the guest ends with a message instead
+                constexpr std::string_view message { "\n** Program Faulted **\n" };
+                m->display.write(message.data(), message.size());
+            }
+            m->display.flush();
+
+            // Output goes out before the guest runs on, so it can never get ahead of its connection
+            std::size_t sent {};
+            Io io;
+            while ((io = send_some(socket.fd, out.view(), sent)) == Io::WAIT) {
+                co_await loop.wait(socket.fd, EPOLLOUT);
+            }
+            out.str({});
+            if (io == Io::CLOSED || stop == Interpreter::HALTED || stop == Interpreter::FAULTED) {
+                co_return;
+            }
+
+            if (!m->keyboard.starved()) {
+                co_await loop.yield();
+                continue;
+            }
+            while ((io = receive(socket.fd, m->keyboard)) == Io::WAIT) {
+                co_await loop.wait(socket.fd, EPOLLIN);
+            }
+            if (io == Io::CLOSED) {
+                co_return;
+            }
+        }
+    }
+
+    void Loop::run(const int listener, const Machine &start) {
+        std::array<epoll_event, 64> events;
+        while (true) {
+            // Blocks only when no guest is ready to run
+            const int count { epoll_wait(epoll, events.data(), static_cast<int>(events.size()), ready.empty() ? -1 : 0) };
+            for (int i {}; i < count; ++i) {
+                if (events[i].data.ptr) {
+                    ready.push_back(std::coroutine_handle<>::from_address(events[i].data.ptr));
+                    continue;
+                }
+                // Another worker may have taken the connection already, then accept just fails
+                int fd;
+                while ((fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    ready.push_back(guest(*this, fd, start).handle);
+                }
+            }
+
+            // Only the guests ready now run, the ones that yield run again after the next look at epoll
+            for (std::size_t waiting { ready.size() }; waiting > 0; --waiting) {
+                const std::coroutine_handle<> next { ready.front() };
+                ready.pop_front();
+                next.resume();
+            }
+        }
+    }
+
+}
+
+bool Host::serve(const Machine &start, const Options &options) {
+    const int listener { socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0) };
+    if (listener < 0) {
+        return false;
+    }
+
+    const int reuse { 1 };
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof reuse);
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(options.port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof address) != 0
+        || ::listen(listener, SOMAXCONN) != 0) {
+        close(listener);
+        return false;
+    }
+
+    const auto work = [&] {
+        Loop loop;
+        if (loop.listen(listener)) {
+            loop.run(listener, start);
+        }
+    };
+
+    const unsigned threads { options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency()) };
+    std::vector<std::thread> workers;
+    for (unsigned i { 1 }; i < threads; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    close(listener);
+    return true;
+}
+
+#else
+
+bool Host::serve(const Machine &, const Options &) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,48 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_HOST_HPP
+#define LC3VM_HOST_HPP
+#include <cstdint>
+
+/* Hosting waits on sockets with epoll */
+#if defined(__linux__)
+#define LC3VM_HOST 1
+#else
+#define LC3VM_HOST 0
+#endif
+
+class Machine;
+
+namespace Host {
+
+    /* Whether guests can be hosted on this platform */
+    constexpr bool supported() {
+        return LC3VM_HOST;
+    }
+
+    struct Options {
+        std::uint16_t port;  /* TCP port on 127.0.0.1 */
+        unsigned threads {}; /* Workers, 0 for one per core */
+    };
+
+    /*
+     * Serves a guest to every connection: a copy of start, whose keyboard reads what
+     * the connection sends and whose display writes to it. The guest runs until it
+     * halts or faults, or the connection is closed.
+     *
+     * Every guest is a coroutine on one of a few worker threads, each with its own
+     * epoll loop, so a waiting guest costs its machine and no thread. A guest runs
+     * in slices of a preemptible run (see Interpreter::Quota) and waits between them:
+     * for input when its keyboard starved (a GETC or IN with no key, or polling KBSR
+     * with nothing coming), for the connection when it cannot take more output, and
+     * otherwise behind the other guests that are ready to run.
+     *
+     * Serves until the process ends, returns false if the port cannot be listened on.
+     */
+    bool serve(const Machine &start, const Options &options);
+
+}
+
+#endif //LC3VM_HOST_HPP
@@ -0,0 +1,137 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Image.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "Decode.hpp"
+#include "Machine.hpp"
+#include "PlatformSpecific.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define LC3VM_SIMD_SWAP 1
+#else
+#define LC3VM_SIMD_SWAP 0
+#endif
+
+namespace {
+
+    void swap_words_scalar(const std::uint8_t *const src, std::uint16_t *const dst, const std::size_t count) {
+        for (std::size_t i {}; i < count; ++i) {
+            dst[i] = static_cast<std::uint16_t>(src[2 * i] << 8 | src[2 * i + 1]);
+        }
+    }
+
+#if LC3VM_SIMD_SWAP
+    /* Swaps the bytes of each 16 bit word, lane by lane */
+    __attribute__((target("ssse3")))
+    void swap_words_ssse3(const std::uint8_t *const src, std::uint16_t *const dst, const std::size_t count) {
+        const __m128i shuffle { _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14) };
+        std::size_t i {};
+        for (; i + 8 <= count; i += 8) {
+            const __m128i words { _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * i)) };
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_shuffle_epi8(words, shuffle));
+        }
+        swap_words_scalar(src + 2 * i, dst + i, count - i);
+    }
+
+    __attribute__((target("avx2")))
+    void swap_words_avx2(const std::uint8_t *const src, std::uint16_t *const dst, const std::size_t count) {
+        const __m256i shuffle { _mm256_setr_epi8(
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14
+        ) };
+        std::size_t i {};
+        for (; i + 16 <= count; i += 16) {
+            const __m256i words { _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 2 * i)) };
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_shuffle_epi8(words, shuffle));
+        }
+        swap_words_scalar(src + 2 * i, dst + i, count - i);
+    }
+#endif
+
+    /* Copies count big endian words from src into dst in host byte order */
+    void swap_words(const std::uint8_t *const src, std::uint16_t *const dst, const std::size_t count) {
+        if constexpr (std::endian::native == std::endian::big) {
+            std::memcpy(dst, src, count * sizeof(std::uint16_t));
+            return;
+        }
+#if LC3VM_SIMD_SWAP
+        static const auto swap { __builtin_cpu_supports("avx2") ? &swap_words_avx2
+                               : __builtin_cpu_supports("ssse3") ? &swap_words_ssse3
+                               : &swap_words_scalar };
+        swap(src, dst, count);
+#else
+        swap_words_scalar(src, dst, count);
+#endif
+    }
+
+}
+
+bool Image::load(Machine &m, const std::uint8_t *const data, const std::size_t size) {
+    // Needs at least the origin
+    if (size < sizeof(std::uint16_t)) {
+        return false;
+    }
+
+    // where to place the program in memory, lc3 programs are big endian
+    const std::uint16_t start_addr ( data[0] << 8 | data[1] );
+
+    // Anything that would run past the end of memory is dropped, as is a trailing odd byte
+    const std::size_t count { std::min((size - sizeof(std::uint16_t)) / sizeof(std::uint16_t),
+                                       Memory::mem_amt - start_addr) };
+
+    swap_words(data + sizeof(std::uint16_t), &m.mem[start_addr], count);
+
+    // Decode the program up front so the interpreter does not have to on first run
+    Decode::predecode(m, start_addr, count);
+
+    return true;
+}
+
+bool Image::read(Machine &m, const char *const filename) {
+#if defined(__unix__) || defined(__linux__) || defined(__APPLE__)
+    const int fd { open(filename, O_RDONLY) };
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    const auto size { static_cast<std::size_t>(st.st_size) };
+    void *const data { mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) };
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    const bool loaded { load(m, static_cast<const std::uint8_t *>(data), size) };
+    munmap(data, size);
+    return loaded;
+#else
+    std::ifstream file_stream {filename, std::ios::binary};
+
+    if (file_stream.bad() || !file_stream.is_open()) {
+        return false;
+    }
+
+    const std::vector<std::uint8_t> data {
+        std::istreambuf_iterator<char> { file_stream },
+        std::istreambuf_iterator<char> {}
+    };
+
+    return load(m, data.data(), data.size());
+#endif
+}
@@ -0,0 +1,26 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_IMAGE_HPP
+#define LC3VM_IMAGE_HPP
+#include <cstddef>
+#include <cstdint>
+
+class Machine;
+
+namespace Image {
+
+    /*
+     * Places an object image (big endian origin followed by big endian words) into
+     * the machine's memory at its origin and predecodes it. Loading several images
+     * into one machine places each of their segments, later images win where they overlap.
+     */
+    bool load(Machine &, const std::uint8_t *data, std::size_t size);
+
+    /* Maps an object file and loads it with Image::load */
+    bool read(Machine &, const char *filename);
+
+}
+
+#endif //LC3VM_IMAGE_HPP
@@ -0,0 +1,484 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Interpreter.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include "Decode.hpp"
+#include "Machine.hpp"
+#include "Opcodes.hpp"
+#include "Profile.hpp"
+#include "Registers.hpp"
+#include "Trap.hpp"
+
+/* Labels as values are a GNU extension, everything else dispatches through a switch */
+#if defined(__GNUC__) || defined(__clang__)
+#define LC3VM_COMPUTED_GOTO 1
+#else
+#define LC3VM_COMPUTED_GOTO 0
+#endif
+
+/* Counted runs stop once the budget is used up, preemptible runs only count, the others compile both out */
+#define CHARGE()                            \
+    do {                                    \
+        if constexpr (counted) {            \
+            if (budget == 0) {              \
+                goto out_of_budget;         \
+            }                               \
+            --budget;                       \
+        }                                   \
+        if constexpr (preemptible) {        \
+            ++executed;                     \
+        }                                   \
+    } while (false)
+
+/*
+ * Preemptible runs check their quota after control transfers and when PC wraps
+ * around to 0, so straight line code costs nothing but the count. The clock is only
+ * read every clock_interval instructions, which is also when a guest polling a
+ * starved keyboard gives up the thread.
+ */
+#define YIELD_POINT()                                                                       \
+    do {                                                                                    \
+        if constexpr (preemptible) {                                                        \
+            if (executed >= next_check) [[unlikely]] {                                      \
+                if (executed >= quota->instructions || m.keyboard.starved()                 \
+                    || std::chrono::steady_clock::now() >= quota->deadline) {               \
+                    goto preempted;                                                         \
+                }                                                                           \
+                next_check = std::min(quota->instructions, executed + clock_interval);      \
+            }                                                                               \
+        }                                                                                   \
+    } while (false)
+
+#define YIELD_IF_WRAPPED()                                  \
+    do {                                                    \
+        if constexpr (preemptible) {                        \
+            if (pc == 0) [[unlikely]] {                     \
+                YIELD_POINT();                              \
+            }                                               \
+        }                                                   \
+    } while (false)
+
+/* Profiled runs count every instruction, all other runs compile it out */
+#define PROFILE(...)                        \
+    do {                                    \
+        if constexpr (profiled) {           \
+            __VA_ARGS__;                    \
+        }                                   \
+    } while (false)
+
+#if LC3VM_COMPUTED_GOTO
+#define HANDLER(op) op_##op
+#define DISPATCH()                                          \
+    do {                                                    \
+        YIELD_IF_WRAPPED();                                 \
+        CHARGE();                                           \
+        PROFILE(profile->instruction(pc, m.mem[pc]));       \
+        in = &m.decoded[pc++];                              \
+        goto *handlers[in->handler];                        \
+    } while (false)
+#else
+#define HANDLER(op) case Decode::op: op_##op
+#define DISPATCH() goto dispatch
+#endif
+
+/*
+ * Superinstructions run as their first instruction alone when one of the words they
+ * cover is no longer fusable, in profiled runs, which account for every instruction
+ * separately, and in counted runs when the budget does not cover all of them.
+ * Otherwise counted runs charge the rest of the sequence up front.
+ */
+#define UNFUSED_IF_STALE(plain, covered)                                                \
+    do {                                                                                \
+        if (profiled || (counted && budget < covered - 1)                               \
+            || !Decode::fusable(in[1].handler)                                          \
+            || (covered > 2 && !Decode::fusable(in[2].handler))) {                      \
+            goto op_##plain;                                                            \
+        }                                                                               \
+        if constexpr (counted) {                                                        \
+            budget -= covered - 1;                                                      \
+        }                                                                               \
+        if constexpr (preemptible) {                                                    \
+            executed += covered - 1;                                                    \
+        }                                                                               \
+    } while (false)
+
+/* Instructions a preemptible run executes between looks at the clock, a few microseconds */
+constexpr std::uint64_t clock_interval { 4096 };
+
+/* How long a counted run waits for a key before it looks at interrupted again */
+constexpr std::chrono::milliseconds key_interval { 20 };
+
+static std::atomic<bool> interrupted_flag { false };
+
+/*
+ * Counted runs take budget as the instructions left, preemptible runs as the count
+ * of the instructions executed, which is written back whenever the guest state is.
+ */
+template <bool counted, bool profiled, bool preemptible>
+static Interpreter::Stop execute(Machine &m, std::uint64_t &budget, Profile *const profile,
+                                 const Interpreter::Quota *const quota) {
+    std::array<std::uint16_t, Registers::PC> reg {}; /* R0 through R7 */
+    std::uint16_t pc {};
+    std::uint16_t result {}; /* Last value that set COND, BR computes the flags from it */
+    Decode::Instr *in {}; /* instruction being executed */
+    std::uint64_t executed {};
+    std::uint64_t next_check {}; /* Preemptible runs look at their quota once executed reaches it */
+    if constexpr (preemptible) {
+        next_check = std::min(quota->instructions, clock_interval);
+    }
+
+    /* Copies the guest state between the locals and the machine's registers */
+    const auto load = [&] {
+        for (std::size_t i {}; i < reg.size(); ++i) {
+            reg[i] = m.regs[i];
+        }
+        pc = m.regs[Registers::PC];
+        result = Opcodes::value_of(m.regs[Registers::COND]);
+    };
+    const auto store = [&] {
+        for (std::size_t i {}; i < reg.size(); ++i) {
+            m.regs[i] = reg[i];
+        }
+        m.regs[Registers::PC] = pc;
+        m.regs[Registers::COND] = Opcodes::cond_of(result);
+        if constexpr (preemptible) {
+            budget = executed;
+        }
+    };
+
+    /* Guest memory accesses, which also count towards the profile */
+    const auto read = [&](const std::uint16_t addr) {
+        PROFILE(profile->read(addr));
+        return m.read(addr);
+    };
+    const auto write = [&](const std::uint16_t addr, const std::uint16_t val) {
+        PROFILE(profile->write(addr));
+        return m.write(addr, val);
+    };
+
+#if LC3VM_COMPUTED_GOTO
+    /* Indexed by handler, same order as the Decode enum */
+    static const void *const handlers[] {
+        &&op_UNDECODED, &&op_BREAK, &&op_BR, &&op_ADD_REG, &&op_ADD_IMM, &&op_LD, &&op_ST, &&op_JSR,
+        &&op_JSRR, &&op_AND_REG, &&op_AND_IMM, &&op_LDR, &&op_STR, &&op_RTI, &&op_NOT, &&op_LDI,
+        &&op_STI, &&op_JMP, &&op_RES, &&op_LEA, &&op_TRAP, &&op_HALT,
+        &&op_ADD_IMM_BR, &&op_LDR_ADD_STR, &&op_AND_ZERO_ADD, &&op_LEA_PUTS,
+    };
+    static_assert(std::size(handlers) == Decode::COUNT);
+#endif
+
+    load();
+    DISPATCH();
+
+#if !LC3VM_COMPUTED_GOTO
+dispatch:
+    YIELD_IF_WRAPPED();
+    CHARGE();
+    PROFILE(profile->instruction(pc, m.mem[pc]));
+    in = &m.decoded[pc++];
+decoded:
+    switch (in->handler) {
+#endif
+
+    /* First run of this word since it was loaded or overwritten, decoding it also fuses it with its neighbours */
+    HANDLER(UNDECODED): {
+        Decode::predecode(m, static_cast<std::uint16_t>(pc - 1), 1);
+#if LC3VM_COMPUTED_GOTO
+        goto *handlers[in->handler];
+#else
+        goto decoded;
+#endif
+    }
+
+    HANDLER(BR): {
+        if (in->dr & Opcodes::cond_of(result)) {
+            pc += in->imm;
+            PROFILE(++profile->branches_taken);
+            YIELD_POINT();
+        } else {
+            PROFILE(++profile->branches_not_taken);
+        }
+        DISPATCH();
+    }
+
+    HANDLER(ADD_REG): {
+        reg[in->dr] = reg[in->sr1] + reg[in->sr2];
+        result = reg[in->dr];
+        DISPATCH();
+    }
+
+    HANDLER(ADD_IMM): {
+        reg[in->dr] = reg[in->sr1] + in->imm;
+        result = reg[in->dr];
+        DISPATCH();
+    }
+
+    HANDLER(LD): {
+        reg[in->dr] = read(pc + in->imm);
+        result = reg[in->dr];
+        DISPATCH();
+    }
+
+    HANDLER(ST): {
+        if (!write(pc + in->imm, reg[in->dr])) [[unlikely]] {
+            goto stopped;
+        }
+        DISPATCH();
+    }
+
+    HANDLER(JSR): {
+        reg[Registers::R7] = pc;
+        pc += in->imm;
+        YIELD_POINT();
+        DISPATCH();
+    }
+
+    /* R7 is written before the base register is read, matching Opcodes::exec<JSR> */
+    HANDLER(JSRR): {
+        reg[Registers::R7] = pc;
+        pc = reg[in->sr1];
+        YIELD_POINT();
+        DISPATCH();
+    }
+
+    /* Neither AND handler touches COND, matching Opcodes::exec<AND> */
+    HANDLER(AND_REG): {
+        reg[in->dr] = reg[in->sr1] & reg[in->sr2];
+        DISPATCH();
+    }
+
+    HANDLER(AND_IMM): {
+        reg[in->dr] = reg[in->sr1] & in->imm;
+        DISPATCH();
+    }
+
+    HANDLER(LDR): {
+        reg[in->dr] = read(reg[in->sr1] + in->imm);
+        result = reg[in->dr];
+        DISPATCH();
+    }
+
+    HANDLER(STR): {
+        if (!write(reg[in->sr1] + in->imm, reg[in->dr])) [[unlikely]] {
+            goto stopped;
+        }
+        DISPATCH();
+    }
+
+    HANDLER(NOT): {
+        reg[in->dr] = ~reg[in->sr1];
+        result = reg[in->dr];
+        DISPATCH();
+    }
+
+    HANDLER(LDI): {
+        reg[in->dr] = read(read(pc + in->imm));
+        result = reg[in->dr];
+        DISPATCH();
+    }
+
+    HANDLER(STI): {
+        if (!write(read(pc + in->imm), reg[in->dr])) [[unlikely]] {
+            goto stopped;
+        }
+        DISPATCH();
+    }
+
+    HANDLER(JMP): {
+        pc = reg[in->sr1];
+        YIELD_POINT();
+        DISPATCH();
+    }
+
+    HANDLER(LEA): {
+        reg[in->dr] = pc + in->imm;
+        result = reg[in->dr];
+        DISPATCH();
+    }
+
+    /* Traps run the regular Trap implementations against the machine's registers */
+    HANDLER(TRAP): {
+        // A trap that reads a starved keyboard waits outside of the run, it runs again once a key was fed
+        if constexpr (preemptible) {
+            if ((in->imm == Trap::GETC || in->imm == Trap::IN) && m.keyboard.starve()) [[unlikely]] {
+                --pc;
+                --executed;
+                goto preempted;
+            }
+        }
+        // One that waits for a key does it here, where an interrupt can still stop the run before the trap
+        if constexpr (counted) {
+            if ((in->imm == Trap::GETC || in->imm == Trap::IN) && !m.keyboard.ready()) [[unlikely]] {
+                while (!m.keyboard.wait_for(key_interval)) {
+                    if (interrupted_flag.load(std::memory_order_relaxed)) {
+                        --pc;
+                        ++budget;
+                        goto out_of_budget;
+                    }
+                }
+            }
+        }
+        PROFILE(++profile->traps[in->word & 0xFF]);
+        store();
+        Opcodes::exec<Opcodes::TRAP>(m, in->word);
+        load();
+        YIELD_POINT();
+        DISPATCH();
+    }
+
+    /* Stops before the instruction runs like BREAK, the caller decides whether to panic */
+    HANDLER(RTI):
+    HANDLER(RES): {
+        --pc;
+        if constexpr (counted) {
+            ++budget;
+        }
+        if constexpr (preemptible) {
+            --executed;
+        }
+        PROFILE(--profile->pcs[pc], --profile->opcodes[m.mem[pc] >> 12]);
+        store();
+        return Interpreter::FAULTED;
+    }
+
+    HANDLER(HALT): {
+        PROFILE(++profile->traps[Trap::HALT]);
+        store();
+        Trap::exec<Trap::HALT>(m);
+        return Interpreter::HALTED;
+    }
+
+    /* A store cleared the clock enable bit in MCR or hit a watchpoint, pc is already past it */
+    stopped: {
+        store();
+        return m.running() ? Interpreter::WATCHPOINT : Interpreter::HALTED;
+    }
+
+    HANDLER(ADD_IMM_BR): {
+        UNFUSED_IF_STALE(ADD_IMM, 2);
+        reg[in->dr] = reg[in->sr1] + in->imm;
+        result = reg[in->dr];
+        ++pc;
+        if (in[1].dr & Opcodes::cond_of(result)) {
+            pc += in[1].imm;
+            YIELD_POINT();
+        }
+        DISPATCH();
+    }
+
+    HANDLER(LDR_ADD_STR): {
+        UNFUSED_IF_STALE(LDR, 3);
+        const std::uint16_t addr ( reg[in->sr1] + in->imm );
+        reg[in->dr] = read(addr) + in[1].imm;
+        result = reg[in->dr];
+        pc += 2;
+        if (!write(addr, reg[in->dr])) [[unlikely]] {
+            goto stopped;
+        }
+        DISPATCH();
+    }
+
+    HANDLER(AND_ZERO_ADD): {
+        UNFUSED_IF_STALE(AND_IMM, 2);
+        reg[in->dr] = 0;
+        reg[in[1].dr] = in[1].imm;
+        result = in[1].imm;
+        ++pc;
+        DISPATCH();
+    }
+
+    HANDLER(LEA_PUTS): {
+        UNFUSED_IF_STALE(LEA, 2);
+        reg[Registers::R0] = pc + in->imm;
+        result = reg[Registers::R0];
+        ++pc;
+        store();
+        Opcodes::exec<Opcodes::TRAP>(m, in[1].word);
+        load();
+        YIELD_POINT();
+        DISPATCH();
+    }
+
+    /* Stops before the instruction runs, it is not charged to the budget */
+    HANDLER(BREAK): {
+        --pc;
+        if constexpr (counted) {
+            ++budget;
+        }
+        if constexpr (preemptible) {
+            --executed;
+        }
+        PROFILE(--profile->pcs[pc], --profile->opcodes[m.mem[pc] >> 12]);
+        store();
+        return Interpreter::BREAKPOINT;
+    }
+
+#if !LC3VM_COMPUTED_GOTO
+        default:
+            break;
+    }
+#endif
+
+    // Only counted runs get here
+[[maybe_unused]] out_of_budget:
+    store();
+    return Interpreter::OUT_OF_BUDGET;
+
+    // Only preemptible runs get here
+[[maybe_unused]] preempted:
+    store();
+    return Interpreter::PREEMPTED;
+}
+
+Interpreter::Stop Interpreter::run(Machine &m) {
+    std::uint64_t unused {};
+    return execute<false, false, false>(m, unused, nullptr, nullptr);
+}
+
+Interpreter::Stop Interpreter::run(Machine &m, std::uint64_t &budget) {
+    return execute<true, false, false>(m, budget, nullptr, nullptr);
+}
+
+Interpreter::Stop Interpreter::run(Machine &m, const Quota &quota, std::uint64_t &executed) {
+    std::uint64_t ran {};
+    const Stop stop { execute<false, false, true>(m, ran, nullptr, &quota) };
+    executed += ran;
+    return stop;
+}
+
+Interpreter::Stop Interpreter::run(Machine &m, Profile &profile) {
+    std::uint64_t unused {};
+    return execute<false, true, false>(m, unused, &profile, nullptr);
+}
+
+void Interpreter::interrupt() {
+    interrupted_flag.store(true, std::memory_order_relaxed);
+}
+
+bool Interpreter::interrupted() {
+    return interrupted_flag.load(std::memory_order_relaxed);
+}
+
+void Interpreter::set_breakpoint(Machine &m, const std::uint16_t addr) {
+    m.decoded[addr].handler = Decode::BREAK;
+}
+
+void Interpreter::clear_breakpoint(Machine &m, const std::uint16_t addr) {
+    m.decoded[addr].handler = Decode::UNDECODED;
+}
+
+void Interpreter::panic(Machine &m) {
+    const std::uint16_t pc { m.regs[Registers::PC] };
+    const std::uint16_t instr { m.mem[pc] };
+    m.regs[Registers::PC] = pc + 1;
+    Opcodes::opcode_funcs[instr >> 12](m, instr);
+    std::abort();
+}
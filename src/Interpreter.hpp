@@ -0,0 +1,77 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_INTERPRETER_HPP
+#define LC3VM_INTERPRETER_HPP
+
+#include <chrono>
+#include <cstdint>
+
+class Machine;
+struct Profile;
+
+namespace Interpreter {
+
+    /* Why run returned */
+    enum Stop {
+        HALTED,        /* The program executed HALT or cleared the clock enable bit in MCR */
+        BREAKPOINT,    /* PC is at a breakpoint, the instruction there has not run yet */
+        OUT_OF_BUDGET, /* The budget ran out, PC is at the next instruction */
+        FAULTED,       /* PC is at an RTI, reserved opcode or TRAP with an unknown vector, which has not run */
+        WATCHPOINT,    /* A store hit a watchpoint (Machine::watch_hit), PC is at the instruction after it */
+        PREEMPTED,     /* The quota ran out, PC is at the next instruction and another run picks up from there */
+    };
+
+    /*
+     * Limits for a guest that shares the host with others. Preemptible runs only check
+     * them where the program can loop: after taken branches, jumps, calls and traps,
+     * and when PC runs off the top of memory. A run stops at the first such point
+     * after a limit is reached, which is never more than 64K instructions past it.
+     * A run also stops when the guest reads a starved keyboard (see Keyboard::HOSTED).
+     */
+    struct Quota {
+        std::uint64_t instructions;                     /* Instructions the run may execute */
+        std::chrono::steady_clock::time_point deadline; /* When the run has to give up the host */
+    };
+
+    /*
+     * Executes the program in the machine's memory starting at its program counter
+     * until the HALT trap or a breakpoint is reached. The guest registers are kept in
+     * locals while running and are only written back to Machine::regs around traps
+     * and when the run stops.
+     */
+    Stop run(Machine &);
+
+    /*
+     * Same as run, but also stops after budget instructions. Subtracts the instructions executed from budget.
+     * Also stops with OUT_OF_BUDGET, PC at the trap, when a GETC or IN that waits for a key is interrupted.
+     */
+    Stop run(Machine &, std::uint64_t &budget);
+
+    /* Same as run, but also stops with PREEMPTED once the quota is used up. Adds the instructions executed to executed */
+    Stop run(Machine &, const Quota &, std::uint64_t &executed);
+
+    /* Same as run, but also counts what the program executes into the profile */
+    Stop run(Machine &, Profile &);
+
+    /*
+     * Asks counted runs to stop, safe to call from a signal handler. Only a GETC or IN
+     * waiting for a key notices it, everything else checks interrupted between runs.
+     */
+    void interrupt();
+    bool interrupted();
+
+    /*
+     * Breakpoints replace the decoded instruction, so they cost nothing while they are
+     * not hit. A store to addr overwrites the breakpoint along with the instruction.
+     */
+    void set_breakpoint(Machine &, std::uint16_t addr);
+    void clear_breakpoint(Machine &, std::uint16_t addr);
+
+    /* Executes the instruction a run FAULTED at like Opcodes::exec does, which reports it and aborts */
+    [[noreturn]] void panic(Machine &);
+
+}
+
+#endif //LC3VM_INTERPRETER_HPP
@@ -0,0 +1,814 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Jit.hpp"
+#include "Interpreter.hpp"
+
+#if LC3VM_JIT
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "Decode.hpp"
+#include "Machine.hpp"
+#include "Memory.hpp"
+#include "Opcodes.hpp"
+#include "PlatformSpecific.hpp"
+#include "Registers.hpp"
+#include "Trap.hpp"
+
+static_assert(sizeof(Decode::Instr) == 8, "generated stores index Machine::decoded with a scale of 8");
+
+namespace {
+
+    /* x86-64 general purpose registers */
+    enum : std::uint8_t { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+    /* Registers the generated code keeps pointers in (all callee saved) */
+    constexpr std::uint8_t REGS { RBX };     /* Machine::regs */
+    constexpr std::uint8_t MEM { R12 };      /* Machine::mem */
+    constexpr std::uint8_t CODE_MAP { R13 }; /* Context::code_map */
+    constexpr std::uint8_t DECODED { R14 };  /* Machine::decoded */
+    constexpr std::uint8_t ENTRIES { R15 };  /* Context::entries */
+
+    constexpr std::uint8_t NO_INDEX { 0xFF };
+
+    /* Condition codes for jcc / cmovcc */
+    enum : std::uint8_t { CC_B = 0x2, CC_Z = 0x4, CC_NZ = 0x5, CC_S = 0x8 };
+
+    constexpr std::size_t code_size { 32 << 20 };  /* Size of the executable buffer */
+    constexpr std::uint16_t max_block_len { 64 };  /* Instructions per block at most */
+    constexpr std::size_t max_block_size { 8192 }; /* Upper bound of the bytes one block compiles to */
+
+    /*
+     * Set in the code map for words with a device attached (the map has a byte per word, so
+     * it can be finer than the bus's pages), the count of covering blocks stays below it
+     */
+    constexpr std::uint8_t io_word { 0x80 };
+    static_assert(max_block_len < io_word);
+
+    /* Guest register -> displacement from REGS */
+    constexpr std::int32_t reg_disp(const std::size_t reg) {
+        return static_cast<std::int32_t>(reg * sizeof(std::uint16_t));
+    }
+
+    /* Writes x86-64 instructions, only the handful of forms the translator needs */
+    class Emitter {
+    public:
+        std::uint8_t *pos;
+
+        explicit Emitter(std::uint8_t *start) : pos { start } {}
+
+        void byte(const std::uint8_t b) {
+            *pos++ = b;
+        }
+
+        void u16(const std::uint16_t v) {
+            std::memcpy(pos, &v, sizeof(v));
+            pos += sizeof(v);
+        }
+
+        void u32(const std::uint32_t v) {
+            std::memcpy(pos, &v, sizeof(v));
+            pos += sizeof(v);
+        }
+
+        void u64(const std::uint64_t v) {
+            std::memcpy(pos, &v, sizeof(v));
+            pos += sizeof(v);
+        }
+
+        /* movzx dst32, word [base + index * 2^scale + disp] */
+        void load16(const std::uint8_t dst, const std::uint8_t base, const std::uint8_t index,
+                    const std::uint8_t scale, const std::int32_t disp) {
+            rex(false, dst, index, base);
+            byte(0x0F);
+            byte(0xB7);
+            mem(dst, base, index, scale, disp);
+        }
+
+        void load16(const std::uint8_t dst, const std::uint8_t base, const std::int32_t disp) {
+            load16(dst, base, NO_INDEX, 0, disp);
+        }
+
+        /* mov word [base + index * 2^scale + disp], src16 */
+        void store16(const std::uint8_t src, const std::uint8_t base, const std::uint8_t index,
+                     const std::uint8_t scale, const std::int32_t disp) {
+            byte(0x66);
+            rex(false, src, index, base);
+            byte(0x89);
+            mem(src, base, index, scale, disp);
+        }
+
+        void store16(const std::uint8_t src, const std::uint8_t base, const std::int32_t disp) {
+            store16(src, base, NO_INDEX, 0, disp);
+        }
+
+        /* mov word [base + disp], imm16 */
+        void store16_imm(const std::uint8_t base, const std::int32_t disp, const std::uint16_t imm) {
+            byte(0x66);
+            rex(false, 0, NO_INDEX, base);
+            byte(0xC7);
+            mem(0, base, NO_INDEX, 0, disp);
+            u16(imm);
+        }
+
+        /* mov byte [base + index * 2^scale + disp], imm8 */
+        void store8_imm(const std::uint8_t base, const std::uint8_t index, const std::uint8_t scale,
+                        const std::int32_t disp, const std::uint8_t imm) {
+            rex(false, 0, index, base);
+            byte(0xC6);
+            mem(0, base, index, scale, disp);
+            byte(imm);
+        }
+
+        /* cmp byte [base + index + disp], imm8 */
+        void cmp8_imm(const std::uint8_t base, const std::uint8_t index, const std::int32_t disp,
+                      const std::uint8_t imm) {
+            rex(false, 7, index, base);
+            byte(0x80);
+            mem(7, base, index, 0, disp);
+            byte(imm);
+        }
+
+        /* test word [base + disp], imm16 */
+        void test16_imm(const std::uint8_t base, const std::int32_t disp, const std::uint16_t imm) {
+            byte(0x66);
+            rex(false, 0, NO_INDEX, base);
+            byte(0xF7);
+            mem(0, base, NO_INDEX, 0, disp);
+            u16(imm);
+        }
+
+        /* test r16, r16 */
+        void test16(const std::uint8_t reg) {
+            byte(0x66);
+            rex(false, reg, NO_INDEX, reg);
+            byte(0x85);
+            byte(0xC0 | (reg & 7) << 3 | (reg & 7));
+        }
+
+        /* <op> dst32, src32 where op is the "r/m32, r32" opcode (add 0x01, and 0x21, mov 0x89) */
+        void op_rr(const std::uint8_t op, const std::uint8_t dst, const std::uint8_t src) {
+            rex(false, src, NO_INDEX, dst);
+            byte(op);
+            byte(0xC0 | (src & 7) << 3 | (dst & 7));
+        }
+
+        /* <op> dst32, imm32 where op is the /digit of opcode 0x81 (add 0, and 4, cmp 7) */
+        void op_ri(const std::uint8_t op, const std::uint8_t dst, const std::int32_t imm) {
+            rex(false, 0, NO_INDEX, dst);
+            byte(0x81);
+            byte(0xC0 | op << 3 | (dst & 7));
+            u32(static_cast<std::uint32_t>(imm));
+        }
+
+        /* not r32 */
+        void not32(const std::uint8_t reg) {
+            rex(false, 0, NO_INDEX, reg);
+            byte(0xF7);
+            byte(0xC0 | 2 << 3 | (reg & 7));
+        }
+
+        /* movzx dst32, src16 */
+        void zext16(const std::uint8_t dst, const std::uint8_t src) {
+            rex(false, dst, NO_INDEX, src);
+            byte(0x0F);
+            byte(0xB7);
+            byte(0xC0 | (dst & 7) << 3 | (src & 7));
+        }
+
+        /* cmovcc dst32, src32 */
+        void cmov(const std::uint8_t cc, const std::uint8_t dst, const std::uint8_t src) {
+            rex(false, dst, NO_INDEX, src);
+            byte(0x0F);
+            byte(0x40 | cc);
+            byte(0xC0 | (dst & 7) << 3 | (src & 7));
+        }
+
+        /* mov r32, imm32 */
+        void mov_imm32(const std::uint8_t reg, const std::uint32_t imm) {
+            rex(false, 0, NO_INDEX, reg);
+            byte(0xB8 | (reg & 7));
+            u32(imm);
+        }
+
+        /* mov r64, imm64 */
+        void mov_imm64(const std::uint8_t reg, const std::uint64_t imm) {
+            rex(true, 0, NO_INDEX, reg);
+            byte(0xB8 | (reg & 7));
+            u64(imm);
+        }
+
+        /* Calls a C++ function, clobbers everything caller saved */
+        template <typename Func>
+        void call(Func *func) {
+            mov_imm64(RAX, reinterpret_cast<std::uint64_t>(func));
+            byte(0xFF);
+            byte(0xD0);
+        }
+
+        /* jmp rel32, returns the position of the rel32 so it can be pointed somewhere later */
+        std::uint8_t *jmp32() {
+            byte(0xE9);
+            u32(0);
+            return pos - 4;
+        }
+
+        /* jcc rel32, returns the position of the rel32 */
+        std::uint8_t *jcc32(const std::uint8_t cc) {
+            byte(0x0F);
+            byte(0x80 | cc);
+            u32(0);
+            return pos - 4;
+        }
+
+        /* jcc rel8 (jmp rel8 when cc is 0xFF), returns the position of the rel8 */
+        std::uint8_t *jcc8(const std::uint8_t cc) {
+            byte(cc == 0xFF ? 0xEB : 0x70 | cc);
+            byte(0);
+            return pos - 1;
+        }
+
+        /* Points a rel8 returned by jcc8 at the current position */
+        void land8(std::uint8_t *const rel) const {
+            *rel = static_cast<std::uint8_t>(pos - (rel + 1));
+        }
+
+        /* jmp qword [base + index * 8] */
+        void jmp_table(const std::uint8_t base, const std::uint8_t index) {
+            rex(false, 4, index, base);
+            byte(0xFF);
+            mem(4, base, index, 3, 0);
+        }
+
+        static void patch32(std::uint8_t *const rel, const std::uint8_t *const target) {
+            const auto offset { static_cast<std::int32_t>(target - (rel + 4)) };
+            std::memcpy(rel, &offset, sizeof(offset));
+        }
+
+        static std::uint8_t *target32(std::uint8_t *const rel) {
+            std::int32_t offset {};
+            std::memcpy(&offset, rel, sizeof(offset));
+            return rel + 4 + offset;
+        }
+
+    private:
+        /* REX prefix, left out when none of its bits are needed */
+        void rex(const bool w, const std::uint8_t reg, const std::uint8_t index, const std::uint8_t base) {
+            const std::uint8_t prefix (
+                0x40 | w << 3 | (reg >> 3 & 1) << 2 | (index != NO_INDEX && index >> 3 & 1) << 1 | (base >> 3 & 1)
+            );
+            if (prefix != 0x40) {
+                byte(prefix);
+            }
+        }
+
+        /* ModRM, SIB and displacement of [base + index * 2^scale + disp] */
+        void mem(const std::uint8_t reg, const std::uint8_t base, const std::uint8_t index,
+                 const std::uint8_t scale, const std::int32_t disp) {
+            std::uint8_t mod { 2 };
+            if (disp == 0 && (base & 7) != RBP) {
+                mod = 0;
+            } else if (disp >= -128 && disp <= 127) {
+                mod = 1;
+            }
+
+            if (index == NO_INDEX && (base & 7) != RSP) {
+                byte(mod << 6 | (reg & 7) << 3 | (base & 7));
+            } else {
+                byte(mod << 6 | (reg & 7) << 3 | RSP);
+                byte(scale << 6 | ((index == NO_INDEX ? static_cast<std::uint8_t>(RSP) : index) & 7) << 3 | (base & 7));
+            }
+
+            if (mod == 1) {
+                byte(static_cast<std::uint8_t>(disp));
+            } else if (mod == 2) {
+                u32(static_cast<std::uint32_t>(disp));
+            }
+        }
+    };
+
+    /* A chained jump from one block into another */
+    struct Link {
+        std::uint8_t *site; /* rel32 of the jump */
+        std::uint8_t *stub; /* where the jump pointed before it was chained */
+    };
+
+    struct Block {
+        std::uint16_t start;
+        std::uint16_t len;             /* Words covered */
+        std::uint8_t *code;
+        std::vector<Link> incoming;    /* Jumps chained into this block */
+    };
+
+    /* Exit codes returned by generated code */
+    enum : std::uint64_t {
+        EXIT_DISPATCH, /* Continue at the machine's PC */
+        /* Anything else is the rel32 of a jump to the machine's PC that can be chained */
+    };
+
+    using entry_func_t = std::uint64_t (*)(const std::uint8_t *);
+
+    /* Whether a decoded instruction ends a block */
+    bool ends_block(const Decode::Instr &instr) {
+        switch (instr.handler) {
+            case Decode::BR:
+                return instr.dr != 0; // BR without any flags never branches
+            case Decode::JSR:
+            case Decode::JSRR:
+            case Decode::JMP:
+            case Decode::TRAP:
+            case Decode::HALT:
+            case Decode::RTI:
+            case Decode::RES:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /* Instructions the dispatcher runs through Opcodes::exec instead of translating */
+    bool interpreted(const Decode::Instr &instr) {
+        return instr.handler == Decode::TRAP || instr.handler == Decode::HALT
+            || instr.handler == Decode::RTI || instr.handler == Decode::RES;
+    }
+
+    bool sets_cond(const Decode::Instr &instr) {
+        switch (instr.handler) {
+            case Decode::ADD_REG:
+            case Decode::ADD_IMM:
+            case Decode::LD:
+            case Decode::LDR:
+            case Decode::NOT:
+            case Decode::LDI:
+            case Decode::LEA:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool is_store(const Decode::Instr &instr) {
+        return instr.handler == Decode::ST || instr.handler == Decode::STR || instr.handler == Decode::STI;
+    }
+
+    /*
+     * Everything the JIT knows about one machine. The code buffer has the machine's
+     * addresses baked in, so a context is only ever used with the machine it was made for.
+     */
+    struct Context {
+        Machine &m;
+
+        std::uint8_t *code {};       /* Start of the executable buffer */
+        std::uint8_t *code_free {};  /* Where the next block gets emitted */
+        std::uint8_t *blocks_start {};
+        std::uint8_t *epilogue {};
+        std::uint8_t *dispatch_exit {};
+        std::size_t generation {};   /* Bumped every time all blocks are flushed */
+
+        std::array<std::unique_ptr<Block>, Memory::mem_amt> blocks {}; /* Indexed by start address */
+        std::array<const std::uint8_t *, Memory::mem_amt> entries {};  /* Native entry or dispatch_exit */
+        std::array<std::uint8_t, Memory::mem_amt> code_map {};         /* Blocks covering each word | io_word */
+
+        explicit Context(Machine &m) : m { m } {}
+
+        Context(const Context &) = delete;
+        Context &operator=(const Context &) = delete;
+
+        ~Context() {
+            if (code) {
+                munmap(code, code_size);
+            }
+        }
+
+        bool init() {
+            void *const buffer { mmap(nullptr, code_size, PROT_READ | PROT_WRITE | PROT_EXEC,
+                                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) };
+            if (buffer == MAP_FAILED) {
+                return false;
+            }
+
+            code = static_cast<std::uint8_t *>(buffer);
+            emit_trampolines();
+            flush();
+            return true;
+        }
+
+        void kill(Block &block) {
+            for (const Link &link : block.incoming) {
+                Emitter::patch32(link.site, link.stub);
+            }
+            entries[block.start] = dispatch_exit;
+            for (std::uint16_t i {}; i < block.len; ++i) {
+                --code_map[static_cast<std::uint16_t>(block.start + i)];
+            }
+            blocks[block.start].reset();
+        }
+
+        void flush() {
+            for (auto &block : blocks) {
+                block.reset();
+            }
+            entries.fill(dispatch_exit);
+            code_map.fill(0);
+            for (std::size_t addr {}; addr < Memory::mem_amt; ++addr) {
+                if (m.bus.device(static_cast<std::uint16_t>(addr))) {
+                    code_map[addr] = io_word;
+                }
+            }
+            code_free = blocks_start;
+            ++generation;
+        }
+
+        /*
+         * Called by generated code after storing into a word that is covered by a block
+         * or has a device. The store already went to memory, devices get it from there.
+         */
+        static void code_written(Context *const ctx, const std::uint16_t addr) {
+            if (ctx->code_map[addr] & io_word) {
+                ctx->m.write(addr, ctx->m.mem[addr]);
+            }
+            for (std::uint16_t i {}; i < max_block_len; ++i) {
+                const std::uint16_t start ( addr - i );
+                if (ctx->blocks[start] && i < ctx->blocks[start]->len) {
+                    ctx->kill(*ctx->blocks[start]);
+                }
+            }
+        }
+
+        /* Called by generated code for loads from words with a device */
+        static std::uint16_t read_io(Context *const ctx, const std::uint16_t addr) {
+            return ctx->m.bus.device(addr)->read(ctx->m, addr);
+        }
+
+        /* Chains the jump at site to block */
+        static void link(std::uint8_t *const site, Block &block) {
+            block.incoming.push_back({ site, Emitter::target32(site) });
+            Emitter::patch32(site, block.code);
+        }
+
+        /* Emits the shared entry and exit code at the start of the buffer */
+        void emit_trampolines() {
+            Emitter e { code };
+
+            // entry_func_t: saves callee saved registers, loads the base pointers and jumps to the block in rdi
+            for (const std::uint8_t reg : { RBX, RBP, R12, R13, R14, R15 }) {
+                if (reg >= R8) {
+                    e.byte(0x41);
+                }
+                e.byte(0x50 | (reg & 7));
+            }
+            e.byte(0x48); // sub rsp, 8 (realign the stack for calls out of generated code)
+            e.byte(0x83);
+            e.byte(0xEC);
+            e.byte(0x08);
+            e.mov_imm64(REGS, reinterpret_cast<std::uint64_t>(m.regs.data()));
+            e.mov_imm64(MEM, reinterpret_cast<std::uint64_t>(m.mem.data()));
+            e.mov_imm64(CODE_MAP, reinterpret_cast<std::uint64_t>(code_map.data()));
+            e.mov_imm64(DECODED, reinterpret_cast<std::uint64_t>(m.decoded.data()));
+            e.mov_imm64(ENTRIES, reinterpret_cast<std::uint64_t>(entries.data()));
+            e.byte(0xFF); // jmp rdi
+            e.byte(0xE7);
+
+            // Returns rax to the caller of entry_func_t
+            epilogue = e.pos;
+            e.byte(0x48); // add rsp, 8
+            e.byte(0x83);
+            e.byte(0xC4);
+            e.byte(0x08);
+            for (const std::uint8_t reg : { R15, R14, R13, R12, RBP, RBX }) {
+                if (reg >= R8) {
+                    e.byte(0x41);
+                }
+                e.byte(0x58 | (reg & 7));
+            }
+            e.byte(0xC3);
+
+            // Entry of every address without a block, PC is already stored
+            dispatch_exit = e.pos;
+            e.op_rr(0x31, RAX, RAX); // xor eax, eax
+            Emitter::patch32(e.jmp32(), epilogue);
+
+            blocks_start = e.pos;
+        }
+
+        Block &compile(std::uint16_t start);
+    };
+
+    /* Emits the pieces of a block that need more than one instruction, one instance per block */
+    class Translator {
+    public:
+        Translator(Context &ctx, std::uint8_t *const start) : e { start }, ctx { ctx } {}
+
+        Emitter e;
+        Context &ctx;
+
+        /* Sets COND from the 16 bit result in eax */
+        void cond_from_eax() {
+            e.test16(RAX);
+            e.mov_imm32(RCX, CondFlags::POS);
+            e.mov_imm32(RDX, CondFlags::ZERO);
+            e.cmov(CC_Z, RCX, RDX);
+            e.mov_imm32(RDX, CondFlags::NEG);
+            e.cmov(CC_S, RCX, RDX);
+            e.store16(RCX, REGS, reg_disp(Registers::COND));
+        }
+
+        /* eax = Machine::read(addr) for an address known at compile time */
+        void load_const(const std::uint16_t addr) {
+            if (ctx.m.bus.device(addr)) {
+                e.mov_imm32(RSI, addr);
+                call_ctx(&Context::read_io);
+                e.zext16(RAX, RAX);
+            } else {
+                e.load16(RAX, MEM, static_cast<std::int32_t>(addr * sizeof(std::uint16_t)));
+            }
+        }
+
+        /* eax = Machine::read(esi) */
+        void load_dynamic() {
+            e.cmp8_imm(CODE_MAP, RSI, 0, io_word);
+            std::uint8_t *const fast { e.jcc8(CC_B) };
+            call_ctx(&Context::read_io);
+            e.zext16(RAX, RAX);
+            std::uint8_t *const done { e.jcc8(0xFF) };
+            e.land8(fast);
+            e.load16(RAX, MEM, RSI, 1, 0);
+            e.land8(done);
+        }
+
+        /* Leaves the block with PC = next if the store hit translated code or a device (address in esi) */
+        void code_check(const std::uint16_t next) {
+            call_ctx(&Context::code_written);
+            e.store16_imm(REGS, reg_disp(Registers::PC), next);
+            e.op_rr(0x31, RAX, RAX); // xor eax, eax
+            Emitter::patch32(e.jmp32(), ctx.epilogue);
+        }
+
+        /* Machine::write(addr, ax) for an address known at compile time */
+        void store_const(const std::uint16_t addr, const std::uint16_t next) {
+            e.store16(RAX, MEM, static_cast<std::int32_t>(addr * sizeof(std::uint16_t)));
+            e.store8_imm(DECODED, NO_INDEX, 0, static_cast<std::int32_t>(addr * sizeof(Decode::Instr)), Decode::UNDECODED);
+            e.cmp8_imm(CODE_MAP, NO_INDEX, addr, 0);
+            std::uint8_t *const skip { e.jcc8(CC_Z) };
+            e.mov_imm32(RSI, addr);
+            code_check(next);
+            e.land8(skip);
+        }
+
+        /* Machine::write(ecx, ax) */
+        void store_dynamic(const std::uint16_t next) {
+            e.store16(RAX, MEM, RCX, 1, 0);
+            e.store8_imm(DECODED, RCX, 3, 0, Decode::UNDECODED);
+            e.cmp8_imm(CODE_MAP, RCX, 0, 0);
+            std::uint8_t *const skip { e.jcc8(CC_Z) };
+            e.op_rr(0x89, RSI, RCX); // mov esi, ecx
+            code_check(next);
+            e.land8(skip);
+        }
+
+        /* Jump to a known address, chained to its block later */
+        void exit_to(std::uint8_t *const site, const std::uint16_t target) {
+            pending.push_back({ site, target });
+        }
+
+        /* Jump to the address in eax through the entries table */
+        void exit_indirect() {
+            e.store16(RAX, REGS, reg_disp(Registers::PC));
+            e.jmp_table(ENTRIES, RAX);
+        }
+
+        /* Emits the stub every exit_to jumps to until it gets chained */
+        void emit_stubs() {
+            for (const auto &[site, target] : pending) {
+                Emitter::patch32(site, e.pos);
+                e.store16_imm(REGS, reg_disp(Registers::PC), target);
+                e.mov_imm64(RAX, reinterpret_cast<std::uint64_t>(site));
+                Emitter::patch32(e.jmp32(), ctx.epilogue);
+            }
+        }
+
+        struct Exit {
+            std::uint8_t *site;
+            std::uint16_t target;
+        };
+        std::vector<Exit> pending;
+
+    private:
+        /* Calls one of the Context helpers with the context as its first argument */
+        template <typename Func>
+        void call_ctx(Func *func) {
+            e.mov_imm64(RDI, reinterpret_cast<std::uint64_t>(&ctx));
+            e.call(func);
+        }
+    };
+
+    /* Translates the block starting at start, which must not begin with an interpreted instruction */
+    Block &Context::compile(const std::uint16_t start) {
+        if (code_free + max_block_size > code + code_size) {
+            flush();
+        }
+
+        std::vector<Decode::Instr> instrs;
+        for (std::uint16_t addr { start }; instrs.size() < max_block_len; ++addr) {
+            instrs.push_back(Decode::decode(m.mem[addr]));
+            if (ends_block(instrs.back())) {
+                break;
+            }
+        }
+
+        // Only the last COND write before the block ends, or before a store that may leave it early, is visible
+        std::vector<bool> cond_live(instrs.size());
+        bool live { true };
+        for (std::size_t i { instrs.size() }; i-- > 0;) {
+            if (sets_cond(instrs[i])) {
+                cond_live[i] = live;
+                live = false;
+            } else if (is_store(instrs[i])) {
+                live = true;
+            }
+        }
+
+        Translator t { *this, code_free };
+        Emitter &e { t.e };
+
+        for (std::size_t i {}; i < instrs.size(); ++i) {
+            const Decode::Instr &in { instrs[i] };
+            const std::uint16_t next ( start + i + 1 ); // PC while the instruction executes
+            const std::uint16_t ea ( next + in.imm );   // PC relative address
+
+            switch (in.handler) {
+                case Decode::BR:
+                    if (in.dr == 0x7) {
+                        t.exit_to(e.jmp32(), ea);
+                    } else if (in.dr != 0) {
+                        e.test16_imm(REGS, reg_disp(Registers::COND), in.dr);
+                        t.exit_to(e.jcc32(CC_Z), next);
+                        t.exit_to(e.jmp32(), ea);
+                    }
+                    break;
+                case Decode::ADD_REG:
+                case Decode::AND_REG:
+                    e.load16(RAX, REGS, reg_disp(in.sr1));
+                    e.load16(RCX, REGS, reg_disp(in.sr2));
+                    e.op_rr(in.handler == Decode::ADD_REG ? 0x01 : 0x21, RAX, RCX);
+                    e.store16(RAX, REGS, reg_disp(in.dr));
+                    break;
+                case Decode::ADD_IMM:
+                case Decode::AND_IMM:
+                    e.load16(RAX, REGS, reg_disp(in.sr1));
+                    e.op_ri(in.handler == Decode::ADD_IMM ? 0 : 4, RAX, in.imm);
+                    e.store16(RAX, REGS, reg_disp(in.dr));
+                    break;
+                case Decode::NOT:
+                    e.load16(RAX, REGS, reg_disp(in.sr1));
+                    e.not32(RAX);
+                    e.store16(RAX, REGS, reg_disp(in.dr));
+                    break;
+                case Decode::LEA:
+                    e.mov_imm32(RAX, ea);
+                    e.store16(RAX, REGS, reg_disp(in.dr));
+                    break;
+                case Decode::LD:
+                    t.load_const(ea);
+                    e.store16(RAX, REGS, reg_disp(in.dr));
+                    break;
+                case Decode::LDR:
+                    e.load16(RSI, REGS, reg_disp(in.sr1));
+                    e.op_ri(0, RSI, static_cast<std::int16_t>(in.imm));
+                    e.zext16(RSI, RSI);
+                    t.load_dynamic();
+                    e.store16(RAX, REGS, reg_disp(in.dr));
+                    break;
+                case Decode::LDI:
+                    t.load_const(ea);
+                    e.op_rr(0x89, RSI, RAX);
+                    t.load_dynamic();
+                    e.store16(RAX, REGS, reg_disp(in.dr));
+                    break;
+                case Decode::ST:
+                    e.load16(RAX, REGS, reg_disp(in.dr));
+                    t.store_const(ea, next);
+                    break;
+                case Decode::STR:
+                    e.load16(RCX, REGS, reg_disp(in.sr1));
+                    e.op_ri(0, RCX, static_cast<std::int16_t>(in.imm));
+                    e.zext16(RCX, RCX);
+                    e.load16(RAX, REGS, reg_disp(in.dr));
+                    t.store_dynamic(next);
+                    break;
+                case Decode::STI:
+                    t.load_const(ea);
+                    e.op_rr(0x89, RCX, RAX);
+                    e.load16(RAX, REGS, reg_disp(in.dr));
+                    t.store_dynamic(next);
+                    break;
+                case Decode::JSR:
+                    e.store16_imm(REGS, reg_disp(Registers::R7), next);
+                    t.exit_to(e.jmp32(), ea);
+                    break;
+                case Decode::JSRR:
+                    // R7 is written before the base register is read, matching Opcodes::exec<JSR>
+                    e.store16_imm(REGS, reg_disp(Registers::R7), next);
+                    e.load16(RAX, REGS, reg_disp(in.sr1));
+                    t.exit_indirect();
+                    break;
+                case Decode::JMP:
+                    e.load16(RAX, REGS, reg_disp(in.sr1));
+                    t.exit_indirect();
+                    break;
+                default:
+                    // Interpreted instruction, the dispatcher runs it
+                    e.store16_imm(REGS, reg_disp(Registers::PC), next - 1);
+                    Emitter::patch32(e.jmp32(), dispatch_exit);
+                    break;
+            }
+
+            if (cond_live[i]) {
+                if (in.handler == Decode::LEA) {
+                    e.store16_imm(REGS, reg_disp(Registers::COND), Opcodes::cond_of(ea));
+                } else {
+                    t.cond_from_eax();
+                }
+            }
+        }
+
+        if (!ends_block(instrs.back())) {
+            t.exit_to(e.jmp32(), start + instrs.size());
+        }
+        t.emit_stubs();
+
+        auto block { std::make_unique<Block>() };
+        block->start = start;
+        block->len = static_cast<std::uint16_t>(instrs.size());
+        block->code = code_free;
+        code_free = e.pos;
+
+        for (std::uint16_t i {}; i < block->len; ++i) {
+            ++code_map[static_cast<std::uint16_t>(start + i)];
+        }
+        entries[start] = block->code;
+        blocks[start] = std::move(block);
+
+        for (const auto &[site, target] : t.pending) {
+            if (blocks[target]) {
+                link(site, *blocks[target]);
+            }
+        }
+
+        return *blocks[start];
+    }
+
+}
+
+void Jit::run(Machine &m) {
+    const auto ctx { std::make_unique<Context>(m) };
+    if (!ctx->init()) {
+        m.out << "** Failed to allocate JIT memory, using the interpreter **\n";
+        if (Interpreter::run(m) == Interpreter::FAULTED) {
+            Interpreter::panic(m);
+        }
+        return;
+    }
+
+    const auto enter { reinterpret_cast<entry_func_t>(ctx->code) };
+    std::uint64_t exit { EXIT_DISPATCH };
+
+    while (m.running()) {
+        const std::uint16_t pc { m.regs[Registers::PC] };
+        const Decode::Instr instr { Decode::decode(m.mem[pc]) };
+
+        if (interpreted(instr)) {
+            m.regs[Registers::PC] = pc + 1;
+            if (instr.handler == Decode::HALT) {
+                Trap::exec<Trap::HALT>(m);
+                return;
+            }
+            Opcodes::opcode_funcs[instr.word >> 12](m, instr.word);
+            exit = EXIT_DISPATCH;
+            continue;
+        }
+
+        const std::size_t gen { ctx->generation };
+        Block &block { ctx->blocks[pc] ? *ctx->blocks[pc] : ctx->compile(pc) };
+        if (exit != EXIT_DISPATCH && gen == ctx->generation) {
+            Context::link(reinterpret_cast<std::uint8_t *>(exit), block);
+        }
+
+        exit = enter(block.code);
+    }
+}
+
+#else
+
+void Jit::run(Machine &m) {
+    if (Interpreter::run(m) == Interpreter::FAULTED) {
+        Interpreter::panic(m);
+    }
+}
+
+#endif
@@ -0,0 +1,35 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_JIT_HPP
+#define LC3VM_JIT_HPP
+
+/* The JIT emits x86-64 machine code into mmap'd memory */
+#if defined(__x86_64__) && (defined(__unix__) || defined(__linux__))
+#define LC3VM_JIT 1
+#else
+#define LC3VM_JIT 0
+#endif
+
+class Machine;
+
+namespace Jit {
+
+    /* Whether the JIT can run on this platform */
+    constexpr bool supported() {
+        return LC3VM_JIT;
+    }
+
+    /*
+     * Executes the machine's program until HALT like Interpreter::run, but
+     * translates basic blocks (ending at BR, JMP, JSR or TRAP) to native code
+     * first. Traps run through Opcodes::exec and accesses to device registers go to
+     * the device, stores into translated code throw away the blocks covering that word.
+     * Falls back to Interpreter::run when the JIT is not supported.
+     */
+    void run(Machine &);
+
+}
+
+#endif //LC3VM_JIT_HPP
@@ -0,0 +1,100 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Keyboard.hpp"
+#include <chrono>
+#include "PlatformSpecific.hpp"
+
+Keyboard::~Keyboard() {
+    stop.store(true, std::memory_order_relaxed);
+    if (reader.joinable()) {
+        reader.join();
+    }
+}
+
+int Keyboard::get() {
+    if (mode == SCRIPTED) {
+        return in.get();
+    }
+    // The host only lets a read run once a key is ready, without one it is the end of the input
+    if (mode == HOSTED) {
+        return next_fed < fed.size() ? static_cast<unsigned char>(fed[next_fed++]) : std::char_traits<char>::eof();
+    }
+    start();
+
+    std::size_t available { head.load(std::memory_order_acquire) };
+    while (available == tail) {
+        head.wait(available, std::memory_order_acquire);
+        available = head.load(std::memory_order_acquire);
+    }
+
+    const int c { ring[tail % capacity] };
+
+    // EOF stays in the ring so every later read sees it too
+    if (c != std::char_traits<char>::eof()) {
+        consumed.store(++tail, std::memory_order_release);
+    }
+    return c;
+}
+
+bool Keyboard::wait_for(const std::chrono::microseconds timeout) {
+    if (mode == SCRIPTED) {
+        return true;
+    }
+    if (mode == HOSTED) {
+        return !starve();
+    }
+    start();
+
+    std::unique_lock lock { waiting };
+    return arrived.wait_for(lock, timeout, [this] { return head.load(std::memory_order_acquire) != tail; });
+}
+
+void Keyboard::feed(const char *const keys, const std::size_t count) {
+    // Everything fed so far has been read most of the time, so the buffer rarely grows
+    if (next_fed == fed.size()) {
+        fed.clear();
+        next_fed = 0;
+    }
+    fed.append(keys, count);
+    hungry = false;
+}
+
+void Keyboard::close() {
+    closed = true;
+    hungry = false;
+}
+
+void Keyboard::read_input() {
+    // How long the reader blocks at a time, which bounds how long destruction waits for it
+    constexpr long poll_us { 50'000 };
+
+    std::size_t next { head.load(std::memory_order_relaxed) };
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        if (next - consumed.load(std::memory_order_acquire) == capacity) {
+            std::this_thread::sleep_for(std::chrono::microseconds { poll_us / 50 });
+            continue;
+        }
+
+        // The terminal is waited on with a timeout so the thread can notice stop, other streams never block for long
+        if (&in == &std::cin && !check_key(poll_us)) {
+            continue;
+        }
+
+        const int c { in.get() };
+        ring[next % capacity] = static_cast<std::int16_t>(c);
+        head.store(++next, std::memory_order_release);
+        head.notify_one();
+        {
+            // Taking the lock orders the store with a wait_for that just checked head, so no wakeup is lost
+            std::lock_guard lock { waiting };
+        }
+        arrived.notify_one();
+
+        if (c == std::char_traits<char>::eof()) {
+            return;
+        }
+    }
+}
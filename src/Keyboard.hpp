@@ -0,0 +1,121 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_KEYBOARD_HPP
+#define LC3VM_KEYBOARD_HPP
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/*
+ * The keyboard device. In ASYNC mode a background thread reads the input stream
+ * into a single producer, single consumer ring, so checking for a key is a load of
+ * the ring's head instead of a select() per KBSR read. The thread is started by
+ * the first call to ready or get, programs that never read input never start it.
+ *
+ * In SCRIPTED mode the stream is a script (a file or buffer) read on the guest's
+ * thread: a key is always ready and it is the script's next character, so a run
+ * depends only on the script and never on timing.
+ *
+ * In HOSTED mode the stream is not used, the host feeds keys as they arrive (see
+ * Host). A read with no key fed does not wait on the guest's thread, the keyboard
+ * starves instead and preemptible runs give the thread back to the host until it
+ * feeds more (see Interpreter::Quota).
+ */
+class Keyboard {
+public:
+    enum Mode {
+        ASYNC,
+        SCRIPTED,
+        HOSTED,
+    };
+
+    Keyboard(std::istream &in, const Mode mode) : in { in }, mode { mode } {}
+    ~Keyboard();
+
+    Keyboard(const Keyboard &) = delete;
+    Keyboard &operator=(const Keyboard &) = delete;
+
+    /* Whether get would return without waiting, which is also true once the input has ended */
+    bool ready() {
+        if (mode == SCRIPTED) {
+            return true;
+        }
+        if (mode == HOSTED) {
+            return next_fed < fed.size() || closed;
+        }
+        start();
+        return head.load(std::memory_order_acquire) != tail;
+    }
+
+    /* Waits for the next character and returns it, or EOF for every call once the input has ended */
+    int get();
+
+    /* Blocks until ready or until timeout has passed, whichever is first, and returns ready() */
+    bool wait_for(std::chrono::microseconds timeout);
+
+    /* HOSTED: keys that arrived for the guest, and the end of its input */
+    void feed(const char *keys, std::size_t count);
+    void close();
+
+    /*
+     * HOSTED: returns true if there is no key to read, which starves the keyboard
+     * until the next feed or close. The other modes never starve, reads wait there.
+     */
+    bool starve() {
+        hungry = mode == HOSTED && !ready();
+        return hungry;
+    }
+
+    bool starved() const {
+        return hungry;
+    }
+
+private:
+    /* Enough for anything pasted into a terminal, the reader waits for room when it is full */
+    static constexpr std::size_t capacity { 4096 };
+
+    void start() {
+        if (!reader.joinable()) [[unlikely]] {
+            reader = std::thread { &Keyboard::read_input, this };
+        }
+    }
+
+    /* Body of the reader thread */
+    void read_input();
+
+    std::istream &in;
+    const Mode mode;
+    std::thread reader;
+    std::atomic<bool> stop { false };
+
+    /* Characters, and EOF as the last entry once the input has ended */
+    std::array<std::int16_t, capacity> ring {};
+
+    /* Written by the reader, each on its own cache line so the two threads do not share one */
+    alignas(64) std::atomic<std::size_t> head {};
+
+    /* Only touched by the guest thread, the reader sees it through consumed */
+    alignas(64) std::size_t tail {};
+    std::atomic<std::size_t> consumed {};
+
+    /* wait_for sleeps on these, the reader notifies after every character */
+    std::mutex waiting;
+    std::condition_variable arrived;
+
+    /* HOSTED: keys fed and not read yet start at next_fed */
+    std::string fed;
+    std::size_t next_fed {};
+    bool closed { false };
+    bool hungry { false };
+};
+
+#endif //LC3VM_KEYBOARD_HPP
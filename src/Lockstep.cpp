@@ -0,0 +1,577 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Lockstep.hpp"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include "Decode.hpp"
+#include "Machine.hpp"
+#include "Memory.hpp"
+#include "Opcodes.hpp"
+#include "Registers.hpp"
+#include "Trap.hpp"
+
+/*
+ * The kernels are plain loops over the lanes, which the compiler turns into vector
+ * code. They are compiled once for the baseline ISA (SSE2 on x86-64, two vectors per
+ * row) and once more for AVX2 (one vector per row), picked when the CPU has it.
+ */
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LC3VM_SIMD_LOCKSTEP 1
+#define LC3VM_LANES_INLINE __attribute__((always_inline)) inline
+#else
+#define LC3VM_SIMD_LOCKSTEP 0
+#define LC3VM_LANES_INLINE inline
+#endif
+
+namespace {
+
+    using Lockstep::lanes;
+
+    /* One 16 bit value per lane */
+    using Row = std::array<std::uint16_t, lanes>;
+
+    /* Once this few lanes are left the interpreter runs them faster than a whole vector does */
+    constexpr std::size_t straggler_lanes { 2 };
+
+}
+
+struct Lockstep::State {
+    /* Word addr of lane l is mem[addr][l], so lanes loading the same address load one vector */
+    alignas(64) std::array<Row, Memory::mem_amt> mem;
+    alignas(64) std::array<Row, Registers::PC> reg;
+    alignas(64) Row pc;
+    alignas(64) Row result; /* Last value that set COND, like the interpreter keeps it */
+    alignas(64) Row active; /* All ones for lanes still running in the group, so kernels select without branches */
+    alignas(64) std::array<std::uint64_t, lanes> executed;
+    std::array<std::size_t, lanes> input_read;
+    std::size_t running;
+
+    /* Words some lane stored to since the group started, every other word is the same in all lanes */
+    std::bitset<Memory::mem_amt> written;
+
+    /* Lanes that leave the group finish on a machine of their own, made when one does */
+    std::istringstream spare_in;
+    std::ostringstream spare_out;
+    std::unique_ptr<Machine> spare;
+};
+
+namespace {
+
+    using Lockstep::Lane;
+    using Lockstep::State;
+
+    LC3VM_LANES_INLINE void blend(Row &dst, const Row &val, const Row &mask) {
+        for (std::size_t l {}; l < lanes; ++l) {
+            dst[l] = static_cast<std::uint16_t>((val[l] & mask[l]) | (dst[l] & ~mask[l]));
+        }
+    }
+
+    LC3VM_LANES_INLINE void blend(Row &dst, const std::uint16_t val, const Row &mask) {
+        for (std::size_t l {}; l < lanes; ++l) {
+            dst[l] = static_cast<std::uint16_t>((val & mask[l]) | (dst[l] & ~mask[l]));
+        }
+    }
+
+    /* Writes val to DR and sets COND from it in the lanes in mask */
+    LC3VM_LANES_INLINE void set_result(State &s, const std::uint8_t dr, const Row &val, const Row &mask) {
+        blend(s.reg[dr], val, mask);
+        blend(s.result, val, mask);
+    }
+
+    LC3VM_LANES_INLINE bool any(const Row &mask) {
+        std::uint16_t bits {};
+        for (std::size_t l {}; l < lanes; ++l) {
+            bits |= mask[l];
+        }
+        return bits != 0;
+    }
+
+    /* The value every lane in mask has, or nothing if they differ */
+    LC3VM_LANES_INLINE std::optional<std::uint16_t> same(const Row &val, const Row &mask) {
+        std::uint16_t low { 0xFFFF }, high {};
+        for (std::size_t l {}; l < lanes; ++l) {
+            low = std::min<std::uint16_t>(low, val[l] | ~mask[l]);
+            high = std::max<std::uint16_t>(high, val[l] & mask[l]);
+        }
+        return low == high ? std::optional<std::uint16_t> { low } : std::nullopt;
+    }
+
+    /*
+     * While every running lane is at the same PC the group is converged: PC is kept
+     * once instead of per lane and instructions are counted once for all lanes, so
+     * a step is the instruction's kernel and little else. Anything that needs PC or
+     * the count of a single lane spreads them out to the lanes first (see diverge).
+     */
+    struct Group {
+        bool converged { false };
+        std::uint16_t pc {};      /* PC of every running lane while converged */
+        std::uint64_t pending {}; /* Instructions every running lane ran that State::executed does not have yet */
+    };
+
+    LC3VM_LANES_INLINE void sync(State &s, Group &g) {
+        for (std::size_t l {}; l < lanes; ++l) {
+            s.executed[l] += s.active[l] ? g.pending : 0;
+        }
+        g.pending = 0;
+    }
+
+    LC3VM_LANES_INLINE void diverge(State &s, Group &g) {
+        if (g.converged) {
+            sync(s, g);
+            blend(s.pc, g.pc, s.active);
+            g.converged = false;
+        }
+    }
+
+    /* The lanes in mask run the instruction, PC moves past it and it is counted */
+    LC3VM_LANES_INLINE void advance(State &s, Group &g, const Row &mask, const std::uint16_t next) {
+        if (g.converged) {
+            g.pc = next;
+            ++g.pending;
+            return;
+        }
+        blend(s.pc, next, mask);
+        for (std::size_t l {}; l < lanes; ++l) {
+            s.executed[l] += mask[l] & 1;
+        }
+    }
+
+    /* The lanes in taken (some of mask) jump to target */
+    LC3VM_LANES_INLINE void jump(State &s, Group &g, const std::uint16_t target, const Row &taken, const Row &mask) {
+        if (g.converged) {
+            if (!any(taken)) {
+                return;
+            }
+            if (taken == mask) {
+                g.pc = target;
+                return;
+            }
+            diverge(s, g);
+        }
+        blend(s.pc, target, taken);
+    }
+
+    /* The lanes in mask jump to the address in their target */
+    LC3VM_LANES_INLINE void jump(State &s, Group &g, const Row &target, const Row &mask) {
+        if (g.converged) {
+            if (const auto to { same(target, mask) }) {
+                g.pc = *to;
+                return;
+            }
+            diverge(s, g);
+        }
+        blend(s.pc, target, mask);
+    }
+
+    /* Lanes in mask whose address is in the I/O region, where loads and stores go to devices */
+    LC3VM_LANES_INLINE Row in_io(const Row &addr, const Row &mask) {
+        Row io;
+        for (std::size_t l {}; l < lanes; ++l) {
+            io[l] = static_cast<std::uint16_t>(addr[l] >= Memory::io_start ? mask[l] : 0);
+        }
+        return io;
+    }
+
+    void finish(State &s, Lane &lane, const std::size_t l, const Interpreter::Stop stop) {
+        s.active[l] = 0;
+        --s.running;
+        lane.stop = stop;
+        lane.executed = s.executed[l];
+    }
+
+    /* Moves lane l to the spare machine as it is, before the instruction at its PC, and runs it to the end there */
+    void eject(State &s, Lane &lane, const std::size_t l) {
+        // A lane leaves once, so each gets a machine of its own and none sees the devices of another
+        s.spare = std::make_unique<Machine>(s.spare_in, s.spare_out, Keyboard::SCRIPTED);
+        Machine &m { *s.spare };
+        m.display.set_policy(Display::ON_HALT);
+
+        for (std::size_t addr {}; addr < Memory::mem_amt; ++addr) {
+            m.mem[addr] = s.mem[addr][l];
+        }
+        for (std::size_t reg {}; reg < s.reg.size(); ++reg) {
+            m.regs[reg] = s.reg[reg][l];
+        }
+        m.regs[Registers::PC] = s.pc[l];
+        m.regs[Registers::COND] = Opcodes::cond_of(s.result[l]);
+        m.control.power_on();
+
+        s.spare_in.str(std::string { lane.input.substr(std::min(s.input_read[l], lane.input.size())) });
+        s.spare_in.clear();
+        s.spare_out.str({});
+
+        const std::uint64_t start_budget { lane.limit - s.executed[l] };
+        std::uint64_t budget { start_budget };
+        const Interpreter::Stop stop { Interpreter::run(m, budget) };
+        m.display.flush();
+
+        lane.output += s.spare_out.view();
+        s.executed[l] += start_budget - budget;
+        finish(s, lane, l, stop);
+    }
+
+    void eject(State &s, const std::span<Lane> group, const Row &mask) {
+        for (std::size_t l {}; l < group.size(); ++l) {
+            if (mask[l]) {
+                eject(s, group[l], l);
+            }
+        }
+    }
+
+    /* A key from the lane's script, or EOF (which a trap reads as 0xFF) once it has run out */
+    unsigned char read_char(State &s, const Lane &lane, const std::size_t l) {
+        if (s.input_read[l] >= lane.input.size()) {
+            return static_cast<unsigned char>(std::char_traits<char>::eof());
+        }
+        return static_cast<unsigned char>(lane.input[s.input_read[l]++]);
+    }
+
+    /* Where the string at addr in lane l ends, or nothing if it runs into the I/O region first */
+    std::optional<std::uint16_t> string_end(const State &s, const std::size_t l, std::uint16_t addr) {
+        for (; addr < Memory::io_start; ++addr) {
+            if (s.mem[addr][l] == 0) {
+                return addr;
+            }
+        }
+        return std::nullopt;
+    }
+
+    /*
+     * Runs a TRAP other than HALT in lane l the way Trap::exec does. Returns false,
+     * without running it, if the lane has to leave the group for it.
+     */
+    bool trap(State &s, Lane &lane, const std::size_t l, const Decode::Instr &in, const std::uint16_t next) {
+        const std::uint16_t r0 { s.reg[Registers::R0][l] };
+        std::optional<std::uint16_t> end;
+        if (in.imm == Trap::PUTS || in.imm == Trap::PUTSP) {
+            end = string_end(s, l, r0);
+            if (!end) {
+                return false;
+            }
+        }
+
+        s.pc[l] = next;
+        ++s.executed[l];
+        s.reg[Registers::R7][l] = next;
+
+        switch (in.imm) {
+            case Trap::GETC: {
+                const unsigned char c { read_char(s, lane, l) };
+                s.reg[Registers::R0][l] = c;
+                s.result[l] = c;
+                break;
+            }
+            case Trap::OUT:
+                lane.output += static_cast<char>(r0);
+                break;
+            case Trap::PUTS:
+                for (std::uint16_t addr { r0 }; addr < *end; ++addr) {
+                    lane.output += static_cast<char>(s.mem[addr][l]);
+                }
+                break;
+            case Trap::IN: {
+                lane.output += Trap::in_prompt;
+                const unsigned char c { read_char(s, lane, l) };
+                lane.output += static_cast<char>(c);
+                s.reg[Registers::R0][l] = c;
+                s.result[l] = c;
+                break;
+            }
+            case Trap::PUTSP:
+                for (std::uint16_t addr { r0 }; addr < *end; ++addr) {
+                    Trap::putsp_chars(s.mem[addr][l], [&](const char c) { lane.output += c; });
+                }
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    /* Lanes that reached their limit stop, returns how many steps the others can take before one does */
+    std::uint64_t check_limits(State &s, const std::span<Lane> group) {
+        std::uint64_t steps { std::numeric_limits<std::uint64_t>::max() };
+        for (std::size_t l {}; l < group.size(); ++l) {
+            if (!s.active[l]) {
+                continue;
+            }
+            if (s.executed[l] == group[l].limit) {
+                finish(s, group[l], l, Interpreter::OUT_OF_BUDGET);
+            } else {
+                steps = std::min(steps, group[l].limit - s.executed[l]);
+            }
+        }
+        return steps;
+    }
+
+    LC3VM_LANES_INLINE void execute(State &s, const std::span<Lane> group) {
+        Group g {};
+        std::uint64_t steps {};
+        while (s.running > straggler_lanes) {
+            // A step advances every lane by one instruction at most, so limits are only checked every so often
+            if (steps == 0) {
+                sync(s, g);
+                steps = check_limits(s, group);
+                continue;
+            }
+            --steps;
+
+            // Otherwise the lowest PC any lane is at runs, lanes that are done count as past the end of memory
+            Row mask;
+            if (!g.converged) {
+                std::uint32_t low { Memory::mem_amt }, high {};
+                for (std::size_t l {}; l < lanes; ++l) {
+                    low = std::min<std::uint32_t>(low, s.active[l] ? s.pc[l] : Memory::mem_amt);
+                    high = std::max<std::uint32_t>(high, s.active[l] ? s.pc[l] : 0);
+                }
+                g.converged = low == high;
+                g.pc = static_cast<std::uint16_t>(low);
+            }
+            const std::uint16_t leader { g.pc };
+            if (g.converged) {
+                mask = s.active;
+            } else {
+                for (std::size_t l {}; l < lanes; ++l) {
+                    mask[l] = static_cast<std::uint16_t>(s.pc[l] == leader ? s.active[l] : 0);
+                }
+            }
+
+            // Lanes that stored to the word may hold different instructions there, the highest one runs first
+            const Row &code { s.mem[leader] };
+            std::uint16_t word { code[0] };
+            if (s.written[leader]) [[unlikely]] {
+                word = 0;
+                for (std::size_t l {}; l < lanes; ++l) {
+                    word = std::max<std::uint16_t>(word, code[l] & mask[l]);
+                }
+                Row running;
+                for (std::size_t l {}; l < lanes; ++l) {
+                    running[l] = static_cast<std::uint16_t>(code[l] == word ? mask[l] : 0);
+                }
+                if (running != mask) {
+                    diverge(s, g);
+                    mask = running;
+                }
+            }
+
+            const Decode::Instr in { Decode::decode(word) };
+            const auto next { static_cast<std::uint16_t>(leader + 1) };
+            Row val;
+
+            switch (in.handler) {
+                case Decode::BR: {
+                    advance(s, g, mask, next);
+                    Row taken;
+                    for (std::size_t l {}; l < lanes; ++l) {
+                        taken[l] = static_cast<std::uint16_t>(in.dr & Opcodes::cond_of(s.result[l]) ? mask[l] : 0);
+                    }
+                    jump(s, g, static_cast<std::uint16_t>(next + in.imm), taken, mask);
+                    break;
+                }
+                case Decode::ADD_REG:
+                    advance(s, g, mask, next);
+                    for (std::size_t l {}; l < lanes; ++l) {
+                        val[l] = s.reg[in.sr1][l] + s.reg[in.sr2][l];
+                    }
+                    set_result(s, in.dr, val, mask);
+                    break;
+                case Decode::ADD_IMM:
+                    advance(s, g, mask, next);
+                    for (std::size_t l {}; l < lanes; ++l) {
+                        val[l] = s.reg[in.sr1][l] + in.imm;
+                    }
+                    set_result(s, in.dr, val, mask);
+                    break;
+                // Neither AND touches COND, like the interpreter
+                case Decode::AND_REG:
+                    advance(s, g, mask, next);
+                    for (std::size_t l {}; l < lanes; ++l) {
+                        val[l] = s.reg[in.sr1][l] & s.reg[in.sr2][l];
+                    }
+                    blend(s.reg[in.dr], val, mask);
+                    break;
+                case Decode::AND_IMM:
+                    advance(s, g, mask, next);
+                    for (std::size_t l {}; l < lanes; ++l) {
+                        val[l] = s.reg[in.sr1][l] & in.imm;
+                    }
+                    blend(s.reg[in.dr], val, mask);
+                    break;
+                case Decode::NOT:
+                    advance(s, g, mask, next);
+                    for (std::size_t l {}; l < lanes; ++l) {
+                        val[l] = static_cast<std::uint16_t>(~s.reg[in.sr1][l]);
+                    }
+                    set_result(s, in.dr, val, mask);
+                    break;
+                case Decode::LEA:
+                    advance(s, g, mask, next);
+                    val.fill(static_cast<std::uint16_t>(next + in.imm));
+                    set_result(s, in.dr, val, mask);
+                    break;
+                case Decode::JSR:
+                    advance(s, g, mask, next);
+                    blend(s.reg[Registers::R7], next, mask);
+                    jump(s, g, static_cast<std::uint16_t>(next + in.imm), mask, mask);
+                    break;
+                // R7 is written before the base register is read, like the interpreter
+                case Decode::JSRR:
+                    advance(s, g, mask, next);
+                    blend(s.reg[Registers::R7], next, mask);
+                    jump(s, g, s.reg[in.sr1], mask);
+                    break;
+                case Decode::JMP:
+                    advance(s, g, mask, next);
+                    jump(s, g, s.reg[in.sr1], mask);
+                    break;
+                case Decode::LD:
+                case Decode::ST: {
+                    // The address is the same in every lane, so the word is one vector
+                    const auto addr { static_cast<std::uint16_t>(next + in.imm) };
+                    if (addr >= Memory::io_start) {
+                        diverge(s, g);
+                        eject(s, group, mask);
+                        break;
+                    }
+                    advance(s, g, mask, next);
+                    if (in.handler == Decode::LD) {
+                        set_result(s, in.dr, s.mem[addr], mask);
+                    } else {
+                        blend(s.mem[addr], s.reg[in.dr], mask);
+                        s.written[addr] = true;
+                    }
+                    break;
+                }
+                case Decode::LDR:
+                case Decode::STR:
+                case Decode::LDI:
+                case Decode::STI: {
+                    // The address can differ between lanes, each lane loads or stores its own word
+                    Row addr;
+                    if (in.handler == Decode::LDR || in.handler == Decode::STR) {
+                        for (std::size_t l {}; l < lanes; ++l) {
+                            addr[l] = s.reg[in.sr1][l] + in.imm;
+                        }
+                    } else {
+                        const auto pointer { static_cast<std::uint16_t>(next + in.imm) };
+                        if (pointer >= Memory::io_start) {
+                            diverge(s, g);
+                            eject(s, group, mask);
+                            break;
+                        }
+                        addr = s.mem[pointer];
+                    }
+
+                    const Row io { in_io(addr, mask) };
+                    if (any(io)) [[unlikely]] {
+                        diverge(s, g);
+                        eject(s, group, io);
+                        for (std::size_t l {}; l < lanes; ++l) {
+                            mask[l] &= static_cast<std::uint16_t>(~io[l]);
+                        }
+                    }
+
+                    advance(s, g, mask, next);
+                    if (in.handler == Decode::LDR || in.handler == Decode::LDI) {
+                        for (std::size_t l {}; l < lanes; ++l) {
+                            val[l] = s.mem[addr[l]][l];
+                        }
+                        set_result(s, in.dr, val, mask);
+                    } else {
+                        for (std::size_t l {}; l < lanes; ++l) {
+                            if (mask[l]) {
+                                s.mem[addr[l]][l] = s.reg[in.dr][l];
+                                s.written[addr[l]] = true;
+                            }
+                        }
+                    }
+                    break;
+                }
+                case Decode::TRAP:
+                    diverge(s, g);
+                    for (std::size_t l {}; l < group.size(); ++l) {
+                        if (mask[l] && !trap(s, group[l], l, in, next)) {
+                            eject(s, group[l], l);
+                        }
+                    }
+                    break;
+                case Decode::HALT:
+                    diverge(s, g);
+                    for (std::size_t l {}; l < group.size(); ++l) {
+                        if (mask[l]) {
+                            s.pc[l] = next;
+                            ++s.executed[l];
+                            group[l].output += Trap::halt_message;
+                            finish(s, group[l], l, Interpreter::HALTED);
+                        }
+                    }
+                    break;
+                // RTI, the reserved opcode and unknown traps fault, which the interpreter reports
+                default:
+                    diverge(s, g);
+                    eject(s, group, mask);
+                    break;
+            }
+        }
+        diverge(s, g);
+    }
+
+    void execute_default(State &s, const std::span<Lane> group) {
+        execute(s, group);
+    }
+
+#if LC3VM_SIMD_LOCKSTEP
+    __attribute__((target("avx2")))
+    void execute_avx2(State &s, const std::span<Lane> group) {
+        execute(s, group);
+    }
+#endif
+
+}
+
+Lockstep::Engine::Engine() : state { std::make_unique<State>() } {}
+
+Lockstep::Engine::~Engine() = default;
+
+void Lockstep::Engine::run(const Machine &start, std::span<Lane> group) {
+    group = group.first(std::min(group.size(), lanes));
+    State &s { *state };
+
+    for (std::size_t addr {}; addr < Memory::mem_amt; ++addr) {
+        s.mem[addr].fill(start.mem[addr]);
+    }
+    for (std::size_t reg {}; reg < s.reg.size(); ++reg) {
+        s.reg[reg].fill(start.regs[reg]);
+    }
+    s.pc.fill(start.regs[Registers::PC]);
+    s.result.fill(Opcodes::value_of(start.regs[Registers::COND]));
+    s.executed.fill(0);
+    s.input_read.fill(0);
+    s.written.reset();
+
+    s.active.fill(0);
+    std::fill_n(s.active.begin(), group.size(), 0xFFFF);
+    s.running = group.size();
+    for (Lane &lane : group) {
+        lane.output.clear();
+    }
+
+#if LC3VM_SIMD_LOCKSTEP
+    static const auto execute_lanes { __builtin_cpu_supports("avx2") ? &execute_avx2 : &execute_default };
+    execute_lanes(s, group);
+#else
+    execute_default(s, group);
+#endif
+
+    for (std::size_t l {}; l < group.size(); ++l) {
+        if (s.active[l]) {
+            eject(s, group[l], l);
+        }
+    }
+}
@@ -0,0 +1,66 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_LOCKSTEP_HPP
+#define LC3VM_LOCKSTEP_HPP
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include "Interpreter.hpp"
+
+class Machine;
+
+namespace Lockstep {
+
+    /* Guests run side by side, one per 16 bit lane of a 256 bit vector */
+    constexpr std::size_t lanes { 16 };
+
+    /* One guest of a group: its keyboard script and budget, and how its run ended */
+    struct Lane {
+        std::string_view input;
+        std::uint64_t limit;
+
+        Interpreter::Stop stop {};
+        std::uint64_t executed {};
+        std::string output {}; /* Everything the guest printed, HALT's message included */
+    };
+
+    struct State;
+
+    /*
+     * Runs up to `lanes` copies of one machine at once, each with its own input, memory
+     * and registers. Registers and memory are stored lane by lane (word addr of every
+     * lane is one vector), so while the guests execute the same instruction it is
+     * executed for all of them with a few vector operations.
+     *
+     * Each step runs the instruction at the lowest PC among the lanes, for the lanes
+     * that are at it. Lanes that branched ahead wait there for the others, which is
+     * where loops with different trip counts meet again. A lane leaves the group for
+     * the regular interpreter, with its state carried over, when it accesses the I/O
+     * region, faults, reaches a string that runs into the I/O region, or is one of
+     * the last few running, so every guest ends exactly like it would on its own.
+     *
+     * The engine keeps its buffers (about 2.5 MiB) for all the groups it runs.
+     */
+    class Engine {
+    public:
+        Engine();
+        ~Engine();
+
+        Engine(const Engine &) = delete;
+        Engine &operator=(const Engine &) = delete;
+
+        /* start is the machine every lane begins as (images loaded), group has at most `lanes` guests */
+        void run(const Machine &start, std::span<Lane> group);
+
+    private:
+        std::unique_ptr<State> state;
+    };
+
+}
+
+#endif //LC3VM_LOCKSTEP_HPP
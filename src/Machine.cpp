@@ -0,0 +1,29 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Machine.hpp"
+
+Machine::Machine(std::istream &in, std::ostream &out)
+    : Machine { in, out, &in == &std::cin ? Keyboard::ASYNC : Keyboard::SCRIPTED } {}
+
+Machine::Machine(std::istream &in, std::ostream &out, const Keyboard::Mode keyboard_mode)
+    : in { in }, out { out }, keyboard { in, keyboard_mode }, display { out } {
+    bus.attach(Memory::KBSR, keyboard_port);
+    bus.attach(Memory::DSR, display_port);
+    bus.attach(Memory::DDR, display_port);
+    bus.attach(Memory::TMR, timer);
+    bus.attach(Memory::TMI, timer);
+    bus.attach(Memory::MCR, control);
+    reset();
+}
+
+void Machine::reset() {
+    /* The default value in the COND register is 0 */
+    write_reg(Registers::COND, CondFlags::ZERO);
+
+    /* Program counter needs to be in the starting position */
+    write_reg(Registers::PC, Registers::pc_start);
+
+    control.power_on();
+}
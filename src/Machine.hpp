@@ -0,0 +1,128 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_MACHINE_HPP
+#define LC3VM_MACHINE_HPP
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include "Bus.hpp"
+#include "Decode.hpp"
+#include "Devices.hpp"
+#include "Display.hpp"
+#include "Keyboard.hpp"
+#include "Memory.hpp"
+#include "Registers.hpp"
+
+class Trace;
+
+/*
+ * All state of one guest: memory, registers and where its input comes from and
+ * output goes to. Nothing is shared between machines, so any number of them can
+ * run at once (one per thread). A machine is about 640 KiB, so allocate it on the heap.
+ * Memory starts on a page boundary so a snapshot can be mapped straight over it.
+ */
+class alignas(4096) Machine {
+public:
+    /* The terminal is read asynchronously, any other stream is treated as an input script */
+    explicit Machine(std::istream &in = std::cin, std::ostream &out = std::cout);
+    Machine(std::istream &in, std::ostream &out, Keyboard::Mode keyboard_mode);
+
+    /* The memory as an array */
+    std::array<std::uint16_t, Memory::mem_amt> mem {};
+
+    /* Values of all registers */
+    std::array<std::uint16_t, Registers::COUNT> regs {};
+
+    /* One decoded instruction for every memory location, zero initialized so everything starts UNDECODED */
+    std::array<Decode::Instr, Memory::mem_amt> decoded {};
+
+    std::istream &in;  /* Where the keyboard reads from */
+    std::ostream &out; /* Where the display writes to */
+
+    Keyboard keyboard;
+    Display display;
+
+    /* Routes the I/O region to the devices below, more can be attached */
+    Bus bus;
+    KeyboardPort keyboard_port;
+    DisplayPort display_port;
+    Timer timer;
+    MachineControl control;
+
+    /* Records or replays the keyboard and timer when set, see Trace */
+    Trace *trace {};
+
+    /* Address of the last store that hit a watchpoint */
+    std::uint16_t watch_hit {};
+
+    /* Puts the registers in their power on state (COND is ZERO and PC is at pc_start) and turns the clock on */
+    void reset();
+
+    /* False once the guest cleared the clock enable bit in MCR */
+    bool running() const {
+        return control.running();
+    }
+
+    std::uint16_t read_reg(const decltype(Registers::COUNT + 0) reg) const {
+        return regs[reg];
+    }
+
+    void write_reg(const decltype(Registers::COUNT + 0) reg, const std::uint16_t val) {
+        regs[reg] = val;
+    }
+
+    /*
+     * A store from the guest, which goes to the device when addr is attached to one.
+     * Returns false if the store stopped the machine (see running) or hit a
+     * watchpoint (see Bus::watch), RAM stores always return true so callers can
+     * test the result for free.
+     */
+    bool write(const std::uint16_t addr, const std::uint16_t val) {
+        if (bus.io(addr)) [[unlikely]] {
+            return write_io(addr, val);
+        }
+        write_ram(addr, val);
+        return true;
+    }
+
+    std::uint16_t read(const std::uint16_t addr) {
+        if (bus.io(addr)) [[unlikely]] {
+            return read_io(addr);
+        }
+        return mem[addr];
+    }
+
+    /*
+     * Stores to memory, bypassing the bus (devices use it for their registers). Stores
+     * also drop the decoded instruction at addr, which keeps self modifying programs working.
+     */
+    void write_ram(const std::uint16_t addr, const std::uint16_t val) {
+        mem[addr] = val;
+        decoded[addr].handler = Decode::UNDECODED;
+    }
+
+private:
+    bool write_io(const std::uint16_t addr, const std::uint16_t val) {
+        if (Device *const device { bus.device(addr) }) {
+            device->write(*this, addr, val);
+        } else {
+            write_ram(addr, val);
+        }
+        if (bus.watching(addr)) [[unlikely]] {
+            watch_hit = addr;
+            return false;
+        }
+        return running();
+    }
+
+    std::uint16_t read_io(const std::uint16_t addr) {
+        if (Device *const device { bus.device(addr) }) {
+            return device->read(*this, addr);
+        }
+        return mem[addr];
+    }
+};
+
+#endif //LC3VM_MACHINE_HPP
@@ -4,9 +4,8 @@
 
 #ifndef LC3VM_MEMORY_HPP
 #define LC3VM_MEMORY_HPP
-#include <array>
+#include <cstddef>
 #include <cstdint>
-#include "PlatformSpecific.hpp"
 
 namespace Memory {
 
@@ -14,29 +13,19 @@ namespace Memory {
     enum {
         KBSR = 0xFE00, /* Keyboard Status Register */
         KBDR = 0xFE02, /* Keyboard Data Register */
+        DSR  = 0xFE04, /* Display Status Register */
+        DDR  = 0xFE06, /* Display Data Register */
+        TMR  = 0xFE08, /* Timer Status Register */
+        TMI  = 0xFE0A, /* Timer Interval Register (milliseconds) */
+        MCR  = 0xFFFE, /* Machine Control Register */
     };
 
+    /* Start of the I/O region, everything below it is plain RAM */
+    constexpr std::uint16_t io_start { 0xFE00 };
+
     /* Amount of memory that the VM has access to (128 KiB, 65536 locations each 16 bits wide) */
     constexpr std::size_t mem_amt { 1 << 16 };
 
-    /* The memory as an array */
-    inline std::array<std::uint16_t, mem_amt> mem;
-
-    inline void write(const std::uint16_t addr, const std::uint16_t val) {
-        mem[addr] = val;
-    }
-
-    inline std::uint16_t read(const std::uint16_t addr) {
-        if (addr == KBSR) {
-            if (check_key()) {
-                mem[KBSR] = 1 << 15;
-                mem[KBDR] = getchar();
-            } else {
-                mem[KBSR] = 0;
-            }
-        }
-        return mem[addr];
-    }
 }
 
-#endif //LC3VM_MEMORY_HPP
\ No newline at end of file
+#endif //LC3VM_MEMORY_HPP
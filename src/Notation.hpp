@@ -0,0 +1,61 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_NOTATION_HPP
+#define LC3VM_NOTATION_HPP
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include "Opcodes.hpp"
+
+/* Numbers and opcodes written the way LC-3 assembly writes them, for options, commands and reports */
+namespace Notation {
+
+    constexpr std::array<std::string_view, Opcodes::COUNT> opcode_names {
+        "BR", "ADD", "LD", "ST", "JSR", "AND", "LDR", "STR",
+        "RTI", "NOT", "LDI", "STI", "JMP", "RES", "LEA", "TRAP",
+    };
+
+    /* Prints addresses, words and vectors in hex, e.g. x3000, or x25 with a width of 2 */
+    struct Hex {
+        std::size_t val;
+        int width { 4 };
+    };
+
+    inline std::ostream &operator<<(std::ostream &os, const Hex hex) {
+        const auto flags { os.flags() };
+        const auto fill { os.fill('0') };
+        os << 'x' << std::uppercase << std::hex << std::setw(hex.width) << hex.val;
+        os.flags(flags);
+        os.fill(fill);
+        return os;
+    }
+
+    /* Parses a decimal number, or a hex one with a 0x or x prefix */
+    template <typename T>
+    std::optional<T> parse_number(std::string_view text) {
+        int base { 10 };
+        if (text.starts_with("0x") || text.starts_with("0X")) {
+            text.remove_prefix(2);
+            base = 16;
+        } else if (text.starts_with("x") || text.starts_with("X")) {
+            text.remove_prefix(1);
+            base = 16;
+        }
+
+        T val {};
+        const auto [end, ec] { std::from_chars(text.data(), text.data() + text.size(), val, base) };
+        if (text.empty() || ec != std::errc {} || end != text.data() + text.size()) {
+            return std::nullopt;
+        }
+        return val;
+    }
+
+}
+
+#endif //LC3VM_NOTATION_HPP
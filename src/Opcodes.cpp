@@ -3,33 +3,21 @@
 //
 
 #include "Opcodes.hpp"
+#include "Machine.hpp"
 #include "Registers.hpp"
 #include "Trap.hpp"
 
-/*
- * Extends number into std::uint16_t. Fills in 0s for positive numbers
- * and 1s for negative numbers. The leftmost bit is the sign bit
- * (0 -> positive, 1 -> negative).
- * @param std::uint16_t x (the actual number being extended)
- * @param std::size_t num_bits (the bits that x originally had)
- */
-std::uint16_t Opcodes::sign_extend(const std::uint16_t x, const std::size_t num_bits) {
-    if (x >> (num_bits - 1) & 0x1) // if this statement is true, x represents a negative number
-        return x | 0xFFFF << num_bits;
-    return x; // otherwise just implicitly cast to std::uint16_t (which fills in 0s)
-}
-
 /*
  * Updates register COND with the information about the sign of the previous calculation
  * @param std::uint16_t reg (the register that has the result of the previous calculation)
  */
-void Opcodes::update_cond(const std::uint16_t reg) {
-    if (Registers::read(reg) == 0) {
-        Registers::write(Registers::COND, CondFlags::ZERO);
-    } else if (Registers::read(reg) >> 15) {
-        Registers::write(Registers::COND, CondFlags::NEG);
+void Opcodes::update_cond(Machine &m, const std::uint16_t reg) {
+    if (m.read_reg(reg) == 0) {
+        m.write_reg(Registers::COND, CondFlags::ZERO);
+    } else if (m.read_reg(reg) >> 15) {
+        m.write_reg(Registers::COND, CondFlags::NEG);
     } else {
-        Registers::write(Registers::COND, CondFlags::POS);
+        m.write_reg(Registers::COND, CondFlags::POS);
     }
 }
 
@@ -39,12 +27,12 @@ void Opcodes::update_cond(const std::uint16_t reg) {
  * set and that bit also matches the one that is in the cond register.
  */
 template<>
-void Opcodes::exec<Opcodes::BR>(const std::uint16_t instr) {
+void Opcodes::exec<Opcodes::BR>(Machine &m, const std::uint16_t instr) {
     const std::uint16_t cond_flag ( instr >> 9 & 0x7 );
-    if (cond_flag & Registers::read(Registers::COND)) {
-        Registers::write(
+    if (cond_flag & m.read_reg(Registers::COND)) {
+        m.write_reg(
             Registers::PC,
-            Registers::read(Registers::PC) + sign_extend(instr & 0x1FF, 9)
+            m.read_reg(Registers::PC) + sign_extend(instr & 0x1FF, 9)
         );
     }
 }
@@ -54,19 +42,19 @@ void Opcodes::exec<Opcodes::BR>(const std::uint16_t instr) {
  * Adds two numbers together.
  */
 template <>
-void Opcodes::exec<Opcodes::ADD>(const std::uint16_t instr) {
+void Opcodes::exec<Opcodes::ADD>(Machine &m, const std::uint16_t instr) {
     const std::uint16_t dr ( instr >> 9 & 0x7 ); // destination register
     const std::uint16_t sr1 ( instr >> 6 & 0x7 ); // operand register
 
     // are we in imm5 mode? evaluates to true if we are.
     if (instr >> 5 & 0x1) {
-        Registers::write(dr, Registers::read(sr1) + sign_extend(instr & 0x1F, 5));
+        m.write_reg(dr, m.read_reg(sr1) + sign_extend(instr & 0x1F, 5));
     } else {
         const std::uint16_t sr2 ( instr & 0x7 );
-        Registers::write(dr, Registers::read(sr1) + Registers::read(sr2));
+        m.write_reg(dr, m.read_reg(sr1) + m.read_reg(sr2));
     }
 
-    update_cond(dr);
+    update_cond(m, dr);
 }
 
 /*
@@ -74,13 +62,13 @@ void Opcodes::exec<Opcodes::ADD>(const std::uint16_t instr) {
  * Loads value behind program counter + memory offset into direct register
  */
 template <>
-void Opcodes::exec<Opcodes::LD>(const std::uint16_t instr) {
+void Opcodes::exec<Opcodes::LD>(Machine &m, const std::uint16_t instr) {
     const std::uint16_t mem_offset { sign_extend(instr & 0x1FF, 9) };
     const std::uint16_t dr ( instr >> 9 & 0x7 );
 
-    Registers::write(dr, Memory::read(Registers::read(Registers::PC) + mem_offset));
+    m.write_reg(dr, m.read(m.read_reg(Registers::PC) + mem_offset));
 
-    update_cond(dr);
+    update_cond(m, dr);
 }
 
 /*
@@ -89,11 +77,11 @@ void Opcodes::exec<Opcodes::LD>(const std::uint16_t instr) {
  * by adding the memory offset to the program counter.
  */
 template <>
-void Opcodes::exec<Opcodes::ST>(const std::uint16_t instr) {
+void Opcodes::exec<Opcodes::ST>(Machine &m, const std::uint16_t instr) {
     const std::uint16_t sr ( instr >> 9 & 0x7 );
     const std::uint16_t mem_offset { sign_extend(instr & 0x1FF, 9) };
 
-    Memory::write(Registers::read(Registers::PC) + mem_offset, Registers::read(sr));
+    m.write(m.read_reg(Registers::PC) + mem_offset, m.read_reg(sr));
 }
 
 /*
@@ -103,17 +91,17 @@ void Opcodes::exec<Opcodes::ST>(const std::uint16_t instr) {
  * is first saved in register 7.
  */
 template <>
-void Opcodes::exec<Opcodes::JSR>(const std::uint16_t instr) {
-    Registers::write(Registers::R7, Registers::read(Registers::PC));
+void Opcodes::exec<Opcodes::JSR>(Machine &m, const std::uint16_t instr) {
+    m.write_reg(Registers::R7, m.read_reg(Registers::PC));
 
     if (instr >> 11 & 0x1 /* use offset or not (11th bit)*/) {
-        Registers::write(
+        m.write_reg(
             Registers::PC,
-            Registers::read(Registers::PC) + sign_extend(instr & 0x7FF, 11)
+            m.read_reg(Registers::PC) + sign_extend(instr & 0x7FF, 11)
         );
     } else {
         const std::uint16_t base_r ( instr >> 6 & 0x7 );
-        Registers::write(Registers::PC, Registers::read(base_r));
+        m.write_reg(Registers::PC, m.read_reg(base_r));
     }
 }
 
@@ -124,15 +112,15 @@ void Opcodes::exec<Opcodes::JSR>(const std::uint16_t instr) {
  * opcode.
  */
 template <>
-void Opcodes::exec<Opcodes::AND>(const std::uint16_t instr) {
+void Opcodes::exec<Opcodes::AND>(Machine &m, const std::uint16_t instr) {
     const std::uint16_t sr1 ( instr >> 6 & 0x7 );
     const std::uint16_t dr ( instr >> 9 & 0x7 );
 
     if (instr >> 5 & 0x1) {
-        Registers::write(dr, Registers::read(sr1) & sign_extend(instr & 0x1F, 5));
+        m.write_reg(dr, m.read_reg(sr1) & sign_extend(instr & 0x1F, 5));
     } else {
         const std::uint16_t sr2 ( instr & 0x7 );
-        Registers::write(dr, Registers::read(sr1) & Registers::read(sr2));
+        m.write_reg(dr, m.read_reg(sr1) & m.read_reg(sr2));
     }
 }
 
@@ -142,14 +130,14 @@ void Opcodes::exec<Opcodes::AND>(const std::uint16_t instr) {
  * of the base register and adding the offset into the direct register.
  */
 template <>
-void Opcodes::exec<Opcodes::LDR>(const std::uint16_t instr) {
+void Opcodes::exec<Opcodes::LDR>(Machine &m, const std::uint16_t instr) {
     const std::uint16_t dr ( instr >> 9 & 0x7);
     const std::uint16_t base_r ( instr >> 6 & 0x7 );
     const std::uint16_t mem_offset { sign_extend(instr & 0x3F, 6) };
 
-    Registers::write(dr, Memory::read(Registers::read(base_r) + mem_offset));
+    m.write_reg(dr, m.read(m.read_reg(base_r) + mem_offset));
 
-    update_cond(dr);
+    update_cond(m, dr);
 }
 
 /*
@@ -158,12 +146,12 @@ void Opcodes::exec<Opcodes::LDR>(const std::uint16_t instr) {
  * the value base register + the offset
  */
 template <>
-void Opcodes::exec<Opcodes::STR>(const std::uint16_t instr) {
+void Opcodes::exec<Opcodes::STR>(Machine &m, const std::uint16_t instr) {
     const std::uint16_t sr ( instr >> 9 & 0x7 );
     const std::uint16_t base_r ( instr >> 6 & 0x7 );
     const std::uint16_t mem_offset { sign_extend(instr & 0x3F, 6) };
 
-    Memory::write(Registers::read(base_r) + mem_offset, Registers::read(sr));
+    m.write(m.read_reg(base_r) + mem_offset, m.read_reg(sr));
 }
 
 /*
@@ -172,13 +160,13 @@ void Opcodes::exec<Opcodes::STR>(const std::uint16_t instr) {
  * then saves it to the direct register.
  */
 template <>
-void Opcodes::exec<Opcodes::NOT>(const std::uint16_t instr) {
+void Opcodes::exec<Opcodes::NOT>(Machine &m, const std::uint16_t instr) {
     const std::uint16_t dr ( instr >> 9 & 0x7 );
     const std::uint16_t sr1 ( instr >> 6 & 0x7 );
 
-    Registers::write(dr, ~Registers::read(sr1));
+    m.write_reg(dr, ~m.read_reg(sr1));
 
-    update_cond(dr);
+    update_cond(m, dr);
 }
 
 /*
@@ -187,13 +175,13 @@ void Opcodes::exec<Opcodes::NOT>(const std::uint16_t instr) {
  * finds value behind that value and loads it into the direct register
  */
 template <>
-void Opcodes::exec<Opcodes::LDI>(const std::uint16_t instr) {
+void Opcodes::exec<Opcodes::LDI>(Machine &m, const std::uint16_t instr) {
     const std::uint16_t mem_offset { sign_extend(instr & 0x1FF, 9) }; /* Offset of memory to access from PC */
     const std::uint16_t dr ( instr >> 9 & 0x7 );
 
-    Registers::write(dr, Memory::read(Memory::read(mem_offset + Registers::read(Registers::PC))));
+    m.write_reg(dr, m.read(m.read(mem_offset + m.read_reg(Registers::PC))));
 
-    update_cond(dr);
+    update_cond(m, dr);
 }
 
 /*
@@ -203,13 +191,13 @@ void Opcodes::exec<Opcodes::LDI>(const std::uint16_t instr) {
  * is stored into that final memory address.
  */
 template <>
-void Opcodes::exec<Opcodes::STI>(const std::uint16_t instr) {
+void Opcodes::exec<Opcodes::STI>(Machine &m, const std::uint16_t instr) {
     const std::uint16_t sr ( instr >> 9 & 0x7 );
     const std::uint16_t mem_offset { sign_extend(instr & 0x1FF, 9) };
 
-    Memory::write(
-        Memory::read(Registers::read(Registers::PC) + mem_offset),
-        Registers::read(sr)
+    m.write(
+        m.read(m.read_reg(Registers::PC) + mem_offset),
+        m.read_reg(sr)
     );
 }
 
@@ -218,10 +206,10 @@ void Opcodes::exec<Opcodes::STI>(const std::uint16_t instr) {
  * Jumps the program counter unconditionally to the value held in the base register
  */
 template <>
-void Opcodes::exec<Opcodes::JMP>(const std::uint16_t instr) {
+void Opcodes::exec<Opcodes::JMP>(Machine &m, const std::uint16_t instr) {
     const std::uint16_t base_r ( instr >> 6 & 0x7 );
 
-    Registers::write(Registers::PC, Registers::read(base_r));
+    m.write_reg(Registers::PC, m.read_reg(base_r));
 }
 
 /*
@@ -229,10 +217,10 @@ void Opcodes::exec<Opcodes::JMP>(const std::uint16_t instr) {
  * The value of the program counter + the offset is loaded into the direct register
  */
 template <>
-void Opcodes::exec<Opcodes::LEA>(const std::uint16_t instr) {
+void Opcodes::exec<Opcodes::LEA>(Machine &m, const std::uint16_t instr) {
     const std::uint16_t dr ( instr >> 9 & 0x7 );
-    Registers::write(dr, Registers::read(Registers::PC) + sign_extend(instr & 0x1FF, 9));
-    update_cond(dr);
+    m.write_reg(dr, m.read_reg(Registers::PC) + sign_extend(instr & 0x1FF, 9));
+    update_cond(m, dr);
 }
 
 /*
@@ -241,28 +229,28 @@ void Opcodes::exec<Opcodes::LEA>(const std::uint16_t instr) {
  * to perform a certain action, such as reading input.
  */
 template <>
-void Opcodes::exec<Opcodes::TRAP>(const std::uint16_t instr) {
+void Opcodes::exec<Opcodes::TRAP>(Machine &m, const std::uint16_t instr) {
 
-    Registers::write(Registers::R7, Registers::read(Registers::PC));
+    m.write_reg(Registers::R7, m.read_reg(Registers::PC));
 
     switch (instr & 0xFF) {
         case Trap::GETC:
-            Trap::exec<Trap::GETC>();
+            Trap::exec<Trap::GETC>(m);
             break;
         case Trap::OUT:
-            Trap::exec<Trap::OUT>();
+            Trap::exec<Trap::OUT>(m);
             break;
         case Trap::PUTS:
-            Trap::exec<Trap::PUTS>();
+            Trap::exec<Trap::PUTS>(m);
             break;
         case Trap::IN:
-            Trap::exec<Trap::IN>();
+            Trap::exec<Trap::IN>(m);
             break;
         case Trap::PUTSP:
-            Trap::exec<Trap::PUTSP>();
+            Trap::exec<Trap::PUTSP>(m);
             break;
         default:
-            Trap::exec<Trap::COUNT>(); // Invalid and panics
+            Trap::exec<Trap::COUNT>(m); // Invalid and panics
             break;
     }
 }
@@ -7,16 +7,51 @@
 #include <cstdint>
 #include <iostream>
 #include <array>
-#include <functional>
 #include "Registers.hpp"
-#include "Memory.hpp"
+
+class Machine;
 
 namespace Opcodes {
 
-    using opcode_func_t = std::function<void(std::uint16_t)>;
+    using opcode_func_t = void (*)(Machine &, std::uint16_t);
+
+    /*
+     * Extends number into std::uint16_t. Fills in 0s for positive numbers
+     * and 1s for negative numbers. The leftmost bit is the sign bit
+     * (0 -> positive, 1 -> negative).
+     * @param std::uint16_t x (the actual number being extended)
+     * @param std::size_t num_bits (the bits that x originally had)
+     */
+    constexpr std::uint16_t sign_extend(const std::uint16_t x, const std::size_t num_bits) {
+        if (x >> (num_bits - 1) & 0x1) // if this statement is true, x represents a negative number
+            return x | 0xFFFF << num_bits;
+        return x; // otherwise just implicitly cast to std::uint16_t (which fills in 0s)
+    }
+
+    /* Returns the condition flag update_cond would set for a register holding val */
+    constexpr std::uint16_t cond_of(const std::uint16_t val) {
+        if (val == 0) {
+            return CondFlags::ZERO;
+        }
+        if (val >> 15) {
+            return CondFlags::NEG;
+        }
+        return CondFlags::POS;
+    }
+
+    /* A value cond_of maps back to flags, for engines that keep the last result instead of COND */
+    constexpr std::uint16_t value_of(const std::uint16_t flags) {
+        switch (flags) {
+            case CondFlags::NEG:
+                return 0x8000;
+            case CondFlags::ZERO:
+                return 0;
+            default:
+                return 1;
+        }
+    }
 
-    std::uint16_t sign_extend(std::uint16_t, std::size_t);
-    void update_cond(std::uint16_t);
+    void update_cond(Machine &, std::uint16_t);
 
     enum {
         BR,    /* Branch */
@@ -43,70 +78,71 @@ namespace Opcodes {
      * Panics as valid instructions are only specialized templates.
      */
     template <decltype(COUNT + 0) opcode>
-    void exec(std::uint16_t) {
+    void exec(Machine &, std::uint16_t) {
         std::cout << "Invalid Opcode: " << opcode << '\n';
         std::abort();
     }
 
     template<>
-    void exec<BR>(std::uint16_t);
+    void exec<BR>(Machine &, std::uint16_t);
 
     template <>
-    void exec<ADD>(std::uint16_t);
+    void exec<ADD>(Machine &, std::uint16_t);
 
     template <>
-    void exec<LD>(std::uint16_t);
+    void exec<LD>(Machine &, std::uint16_t);
 
     template <>
-    void exec<ST>(std::uint16_t);
+    void exec<ST>(Machine &, std::uint16_t);
 
     template <>
-    void exec<JSR>(std::uint16_t);
+    void exec<JSR>(Machine &, std::uint16_t);
 
     template <>
-    void exec<AND>(std::uint16_t);
+    void exec<AND>(Machine &, std::uint16_t);
 
     template <>
-    void exec<LDR>(std::uint16_t);
+    void exec<LDR>(Machine &, std::uint16_t);
 
     template <>
-    void exec<STR>(std::uint16_t);
+    void exec<STR>(Machine &, std::uint16_t);
 
     template <>
-    void exec<NOT>(std::uint16_t);
+    void exec<NOT>(Machine &, std::uint16_t);
 
     template <>
-    void exec<LDI>(std::uint16_t);
+    void exec<LDI>(Machine &, std::uint16_t);
 
     template <>
-    void exec<STI>(std::uint16_t);
+    void exec<STI>(Machine &, std::uint16_t);
 
     template <>
-    void exec<JMP>(std::uint16_t);
+    void exec<JMP>(Machine &, std::uint16_t);
 
     template <>
-    void exec<LEA>(std::uint16_t);
+    void exec<LEA>(Machine &, std::uint16_t);
 
     template <>
-    void exec<TRAP>(std::uint16_t);
-
-    inline const std::array opcode_funcs {
-        opcode_func_t(&exec<BR>),
-        opcode_func_t(&exec<ADD>),
-        opcode_func_t(&exec<LD>),
-        opcode_func_t(&exec<ST>),
-        opcode_func_t(&exec<JSR>),
-        opcode_func_t(&exec<AND>),
-        opcode_func_t(&exec<LDR>),
-        opcode_func_t(&exec<STR>),
-        opcode_func_t(&exec<RES> /* Panics if executed */),
-        opcode_func_t(&exec<NOT>),
-        opcode_func_t(&exec<LDI>),
-        opcode_func_t(&exec<STI>),
-        opcode_func_t(&exec<JMP>),
-        opcode_func_t(&exec<RES> /* Panics if executed */),
-        opcode_func_t(&exec<LEA>),
-        opcode_func_t(&exec<TRAP>),
+    void exec<TRAP>(Machine &, std::uint16_t);
+
+    /* Executes a single instruction when indexed by its opcode (see Interpreter for the main loop) */
+    inline constexpr std::array<opcode_func_t, COUNT> opcode_funcs {
+        &exec<BR>,
+        &exec<ADD>,
+        &exec<LD>,
+        &exec<ST>,
+        &exec<JSR>,
+        &exec<AND>,
+        &exec<LDR>,
+        &exec<STR>,
+        &exec<RES> /* Panics if executed */,
+        &exec<NOT>,
+        &exec<LDI>,
+        &exec<STI>,
+        &exec<JMP>,
+        &exec<RES> /* Panics if executed */,
+        &exec<LEA>,
+        &exec<TRAP>,
     };
 }
 
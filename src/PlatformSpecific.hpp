@@ -11,6 +11,7 @@
 #include <fcntl.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <sys/termios.h>
 #include <sys/mman.h>
 #elif defined(_WIN32)
@@ -27,18 +28,19 @@ DWORD fdwMode, fdwOldMode;
 #error Unrecognized OS
 #endif
 
-inline bool check_key() {
+/* Waits up to timeout_us microseconds for a key, only the keyboard reader thread waits */
+inline bool check_key(const long timeout_us = 0) {
 #if defined(__unix__) || defined(__linux__) || defined(__APPLE__)
     fd_set readfds;
     FD_ZERO(&readfds);
     FD_SET(STDIN_FILENO, &readfds);
 
-    static timeval timeout {};
-    timeout.tv_sec = 0;
-    timeout.tv_usec = 0;
-    return select(1, &readfds, nullptr, nullptr, &timeout) != 0;
+    timeval timeout {};
+    timeout.tv_sec = timeout_us / 1'000'000;
+    timeout.tv_usec = timeout_us % 1'000'000;
+    return select(1, &readfds, nullptr, nullptr, &timeout) > 0;
 #elif defined(_WIN32)
-    return WaitForSingleObject(hStdin, 1000) == WAIT_OBJECT_0 && _kbhit();
+    return WaitForSingleObject(hStdin, timeout_us ? timeout_us / 1000 : 1000) == WAIT_OBJECT_0 && _kbhit();
 #else
 #error Unrecognized OS
 #endif
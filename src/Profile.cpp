@@ -0,0 +1,242 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Profile.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <string_view>
+#include <vector>
+#include "Notation.hpp"
+#include "Trap.hpp"
+
+namespace {
+
+    using Notation::Hex;
+    using Notation::opcode_names;
+
+    constexpr std::array<std::string_view, Profile::REGION_COUNT> region_names {
+        "trap_table", "interrupt_table", "system", "user", "devices",
+    };
+
+    constexpr std::array<std::string_view, Profile::HOST_EVENT_COUNT> host_event_names {
+        "cycles", "instructions", "branch_misses", "l1d_misses", "task_clock_ns",
+    };
+
+    std::string_view trap_name(const std::size_t vector) {
+        switch (vector) {
+            case Trap::GETC: return "GETC";
+            case Trap::OUT: return "OUT";
+            case Trap::PUTS: return "PUTS";
+            case Trap::IN: return "IN";
+            case Trap::PUTSP: return "PUTSP";
+            case Trap::HALT: return "HALT";
+            default: return "";
+        }
+    }
+
+    double percent(const std::uint64_t part, const std::uint64_t total) {
+        return total ? 100.0 * static_cast<double>(part) / static_cast<double>(total) : 0.0;
+    }
+
+    double per(const std::uint64_t count, const std::uint64_t instructions) {
+        return instructions ? static_cast<double>(count) / static_cast<double>(instructions) : 0.0;
+    }
+
+    /* Guest instructions executed in the address range starting at first */
+    std::uint64_t range_instructions(const Profile &profile, const std::size_t first) {
+        return std::accumulate(profile.pcs.begin() + static_cast<std::ptrdiff_t>(first),
+                               profile.pcs.begin() + static_cast<std::ptrdiff_t>(first + Profile::range_size),
+                               std::uint64_t {});
+    }
+
+    /* The host counters as per guest instruction columns, only the ones the host counted */
+    void host_row(std::ostream &os, const Profile &profile, const Profile::HostCounts &counts,
+                  const std::uint64_t instructions) {
+        for (std::size_t event {}; event < Profile::HOST_EVENT_COUNT; ++event) {
+            if (profile.host_counted[event]) {
+                os << std::setw(15) << per(counts[event], instructions);
+            }
+        }
+        os << '\n';
+    }
+
+    /* Host counters sampled per opcode and for the busiest address ranges, if there were any samples */
+    void host_report(std::ostream &os, const Profile &profile) {
+        if (!profile.host_samples) {
+            return;
+        }
+        const Profile::HostEvent leader { profile.host_leader };
+        os << "Host counters per guest instruction (" << profile.host_samples << " samples, one every "
+           << profile.host_period << ' ' << host_event_names[leader] << "):\n";
+        os << std::setprecision(2) << "  " << std::left << std::setw(6) << "" << std::right << std::setw(14)
+           << "executed";
+        for (std::size_t event {}; event < Profile::HOST_EVENT_COUNT; ++event) {
+            if (profile.host_counted[event]) {
+                os << std::setw(15) << host_event_names[event];
+            }
+        }
+        os << '\n';
+        for (std::size_t op {}; op < Opcodes::COUNT; ++op) {
+            if (profile.opcodes[op]) {
+                os << "  " << std::left << std::setw(6) << opcode_names[op] << std::right << std::setw(14)
+                   << profile.opcodes[op];
+                host_row(os, profile, profile.host_opcodes[op], profile.opcodes[op]);
+            }
+        }
+
+        // Ranges by their share of the leader, the JSON lists every sampled range
+        constexpr std::size_t hottest { 10 };
+        std::vector<std::size_t> ranges;
+        for (std::size_t range {}; range < profile.host_ranges.size(); ++range) {
+            if (profile.host_ranges[range][leader]) {
+                ranges.push_back(range);
+            }
+        }
+        const auto shown { std::min(ranges.size(), hottest) };
+        std::partial_sort(ranges.begin(), ranges.begin() + static_cast<std::ptrdiff_t>(shown), ranges.end(),
+                          [&](const std::size_t a, const std::size_t b) {
+                              return profile.host_ranges[a][leader] > profile.host_ranges[b][leader];
+                          });
+
+        std::uint64_t sampled {};
+        for (const Profile::HostCounts &counts : profile.host_opcodes) {
+            sampled += counts[leader];
+        }
+        os << "Hottest address ranges by " << host_event_names[leader] << ":\n" << std::setprecision(1);
+        for (std::size_t i {}; i < shown; ++i) {
+            const std::size_t first { ranges[i] * Profile::range_size };
+            os << "  " << Hex { first, 4 } << '-' << Hex { first + Profile::range_size - 1, 4 } << std::setw(7)
+               << percent(profile.host_ranges[ranges[i]][leader], sampled) << '%' << std::setprecision(2);
+            host_row(os, profile, profile.host_ranges[ranges[i]], range_instructions(profile, first));
+            os << std::setprecision(1);
+        }
+    }
+
+    void host_json(std::ostream &os, const Profile &profile, const Profile::HostCounts &counts) {
+        os << '{';
+        bool first { true };
+        for (std::size_t event {}; event < Profile::HOST_EVENT_COUNT; ++event) {
+            if (profile.host_counted[event]) {
+                os << (first ? "" : ",") << '"' << host_event_names[event] << "\":" << counts[event];
+                first = false;
+            }
+        }
+        os << '}';
+    }
+
+}
+
+void Profile::report(std::ostream &os) const {
+    const std::uint64_t total { std::accumulate(opcodes.begin(), opcodes.end(), std::uint64_t {}) };
+    const auto flags { os.flags() };
+    os << std::fixed << std::setprecision(1);
+
+    os << "** Profile: " << total << " instructions **\n";
+
+    os << "Opcodes:\n";
+    for (std::size_t op {}; op < opcodes.size(); ++op) {
+        if (opcodes[op]) {
+            os << "  " << std::left << std::setw(6) << opcode_names[op] << std::right << std::setw(14) << opcodes[op]
+               << std::setw(7) << percent(opcodes[op], total) << "%\n";
+        }
+    }
+
+    os << "Branches: " << branches_taken << " taken, " << branches_not_taken << " not taken\n";
+
+    os << "Traps:\n";
+    for (std::size_t vector {}; vector < traps.size(); ++vector) {
+        if (traps[vector]) {
+            os << "  " << Hex { vector, 2 } << ' ' << std::left << std::setw(5) << trap_name(vector) << std::right
+               << std::setw(14) << traps[vector] << '\n';
+        }
+    }
+
+    os << "Memory (reads / writes):\n";
+    for (std::size_t region {}; region < REGION_COUNT; ++region) {
+        os << "  " << std::left << std::setw(16) << region_names[region] << std::right << std::setw(14)
+           << reads[region] << " / " << writes[region] << '\n';
+    }
+
+    // Only the busiest addresses, a full listing is in the JSON
+    constexpr std::size_t hottest { 10 };
+    std::vector<std::size_t> addrs;
+    for (std::size_t addr {}; addr < pcs.size(); ++addr) {
+        if (pcs[addr]) {
+            addrs.push_back(addr);
+        }
+    }
+    const auto shown { std::min(addrs.size(), hottest) };
+    std::partial_sort(addrs.begin(), addrs.begin() + static_cast<std::ptrdiff_t>(shown), addrs.end(),
+                      [&](const std::size_t a, const std::size_t b) { return pcs[a] > pcs[b]; });
+
+    os << "Hottest addresses:\n";
+    for (std::size_t i {}; i < shown; ++i) {
+        os << "  " << Hex { addrs[i], 4 } << std::setw(14) << pcs[addrs[i]] << std::setw(7)
+           << percent(pcs[addrs[i]], total) << "%\n";
+    }
+
+    host_report(os, *this);
+    os.flags(flags);
+}
+
+void Profile::write_json(std::ostream &os) const {
+    const std::uint64_t total { std::accumulate(opcodes.begin(), opcodes.end(), std::uint64_t {}) };
+
+    os << "{\"instructions\":" << total << ",\"opcodes\":{";
+    for (std::size_t op {}; op < opcodes.size(); ++op) {
+        os << (op ? "," : "") << '"' << opcode_names[op] << "\":" << opcodes[op];
+    }
+
+    os << "},\"branches\":{\"taken\":" << branches_taken << ",\"not_taken\":" << branches_not_taken << "},\"traps\":{";
+    bool first { true };
+    for (std::size_t vector {}; vector < traps.size(); ++vector) {
+        if (traps[vector]) {
+            os << (first ? "" : ",") << '"' << Hex { vector, 2 } << "\":" << traps[vector];
+            first = false;
+        }
+    }
+
+    os << "},\"regions\":{";
+    for (std::size_t region {}; region < REGION_COUNT; ++region) {
+        os << (region ? "," : "") << '"' << region_names[region] << "\":{\"reads\":" << reads[region]
+           << ",\"writes\":" << writes[region] << '}';
+    }
+
+    os << "},\"pcs\":{";
+    first = true;
+    for (std::size_t addr {}; addr < pcs.size(); ++addr) {
+        if (pcs[addr]) {
+            os << (first ? "" : ",") << '"' << Hex { addr, 4 } << "\":" << pcs[addr];
+            first = false;
+        }
+    }
+    os << '}';
+
+    if (host_samples) {
+        os << ",\"host\":{\"leader\":\"" << host_event_names[host_leader] << "\",\"period\":" << host_period
+           << ",\"samples\":" << host_samples << ",\"totals\":";
+        host_json(os, *this, host_totals);
+        os << ",\"opcodes\":{";
+        first = true;
+        for (std::size_t op {}; op < opcodes.size(); ++op) {
+            if (opcodes[op]) {
+                os << (first ? "" : ",") << '"' << opcode_names[op] << "\":";
+                host_json(os, *this, host_opcodes[op]);
+                first = false;
+            }
+        }
+        os << "},\"ranges\":{";
+        first = true;
+        for (std::size_t range {}; range < host_ranges.size(); ++range) {
+            if (host_ranges[range][host_leader]) {
+                os << (first ? "" : ",") << '"' << Hex { range * range_size, 4 } << "\":";
+                host_json(os, *this, host_ranges[range]);
+                first = false;
+            }
+        }
+        os << "}}";
+    }
+    os << "}\n";
+}
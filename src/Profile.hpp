@@ -0,0 +1,102 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_PROFILE_HPP
+#define LC3VM_PROFILE_HPP
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include "Memory.hpp"
+#include "Opcodes.hpp"
+
+/*
+ * Execution counters filled in by Interpreter::run(Machine &, Profile &). Only
+ * that overload counts anything, every other run compiles the counting out.
+ * The host counters are only filled in while a Counters::Sampler runs.
+ * About 530 KiB, so allocate it on the heap.
+ */
+struct Profile {
+    /* Parts of the LC-3 memory map, memory accesses are counted per region */
+    enum Region {
+        TRAP_TABLE,      /* x0000 - x00FF */
+        INTERRUPT_TABLE, /* x0100 - x01FF */
+        SYSTEM,          /* x0200 - x2FFF */
+        USER,            /* x3000 - xFDFF */
+        DEVICES,         /* xFE00 - xFFFF */
+        REGION_COUNT,
+    };
+
+    /* Host counters sampled while the guest runs, see Counters::Sampler */
+    enum HostEvent {
+        CYCLES,
+        INSTRUCTIONS,
+        BRANCH_MISSES,
+        L1D_MISSES,    /* L1 data cache read misses */
+        TASK_CLOCK,    /* Nanoseconds on the CPU */
+        HOST_EVENT_COUNT,
+    };
+
+    /* Words per address range the host counters are attributed to */
+    static constexpr std::size_t range_size { 256 };
+
+    using HostCounts = std::array<std::uint64_t, HOST_EVENT_COUNT>;
+
+    static constexpr Region region_of(const std::uint16_t addr) {
+        if (addr < 0x0100) {
+            return TRAP_TABLE;
+        }
+        if (addr < 0x0200) {
+            return INTERRUPT_TABLE;
+        }
+        if (addr < 0x3000) {
+            return SYSTEM;
+        }
+        if (addr < Memory::io_start) {
+            return USER;
+        }
+        return DEVICES;
+    }
+
+    std::array<std::uint64_t, Opcodes::COUNT> opcodes {};  /* Instructions executed per opcode */
+    std::array<std::uint64_t, Memory::mem_amt> pcs {};     /* Instructions executed per address */
+    std::array<std::uint64_t, 256> traps {};               /* TRAPs executed per vector */
+    std::array<std::uint64_t, REGION_COUNT> reads {};      /* Loads per region, LDI counts both of its reads */
+    std::array<std::uint64_t, REGION_COUNT> writes {};     /* Stores per region */
+    std::uint64_t branches_taken {};
+    std::uint64_t branches_not_taken {};
+
+    std::array<bool, HOST_EVENT_COUNT> host_counted {};                      /* Events the host could count */
+    HostEvent host_leader {};                                                /* The event the samples were taken on */
+    std::uint64_t host_period {};                                            /* Leader counts between samples */
+    std::uint64_t host_samples {};
+    HostCounts host_totals {};                                               /* Counted over the whole run */
+    std::array<HostCounts, Opcodes::COUNT> host_opcodes {};                  /* Sampled, per opcode */
+    std::array<HostCounts, Memory::mem_amt / range_size> host_ranges {};     /* Sampled, per address range */
+
+    /* The instruction executing, (opcode << 16) | pc, for the sampler to attribute the counters to */
+    std::atomic<std::uint32_t> running {};
+
+    void instruction(const std::uint16_t pc, const std::uint16_t instr) {
+        ++pcs[pc];
+        ++opcodes[instr >> 12];
+        running.store(static_cast<std::uint32_t>(instr >> 12) << 16 | pc, std::memory_order_relaxed);
+    }
+
+    void read(const std::uint16_t addr) {
+        ++reads[region_of(addr)];
+    }
+
+    void write(const std::uint16_t addr) {
+        ++writes[region_of(addr)];
+    }
+
+    /* Human readable summary with the hottest addresses */
+    void report(std::ostream &) const;
+
+    /* Every counter as one JSON object, addresses and vectors that never ran are left out */
+    void write_json(std::ostream &) const;
+};
+
+#endif //LC3VM_PROFILE_HPP
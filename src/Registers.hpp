@@ -5,7 +5,6 @@
 #define LC3VM_REGISTERS_HPP
 
 #include <cstdint>
-#include <array>
 
 /* Condition flags used for results of logical comparisons */
 namespace CondFlags {
@@ -34,16 +33,6 @@ namespace Registers {
 
     constexpr std::uint16_t pc_start {0x3000}; /* default starting position for the program counter */
 
-    inline std::array<std::uint16_t, COUNT> vals {}; /* values of all registers */
-
-    inline std::uint16_t read(const decltype(COUNT + 0) reg) {
-        return vals[reg];
-    }
-
-    inline void write(const decltype(COUNT + 0) reg, std::uint16_t val) {
-        vals[reg] = val;
-    }
-
 }
 
 #endif //LC3VM_REGISTERS_HPP
\ No newline at end of file
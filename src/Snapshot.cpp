@@ -0,0 +1,175 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Snapshot.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "Machine.hpp"
+#include "PlatformSpecific.hpp"
+
+namespace {
+
+    constexpr std::array<char, 8> magic { 'L', 'C', '3', 'S', 'N', 'A', 'P', '\0' };
+    constexpr std::uint32_t version { 2 };
+
+    /* Memory starts one page in so it can be mapped from the file */
+    constexpr std::size_t mem_offset { 4096 };
+    constexpr std::size_t mem_size { Memory::mem_amt * sizeof(std::uint16_t) };
+
+    struct Header {
+        std::array<char, 8> magic;
+        std::uint32_t version;
+        std::uint32_t mem_offset;
+        std::uint64_t executed;
+        std::array<std::uint16_t, Registers::COUNT> regs;
+        std::uint16_t mcr;
+        std::uint64_t timer; /* Milliseconds into the timer's interval */
+    };
+    static_assert(sizeof(Header) <= mem_offset);
+
+    constexpr bool little { std::endian::native == std::endian::little };
+
+    template <typename T>
+    T little_endian(const T val) {
+        if constexpr (little) {
+            return val;
+        } else {
+            T swapped {};
+            for (std::size_t i {}; i < sizeof(T); ++i) {
+                swapped = static_cast<T>(swapped << 8 | (val >> 8 * i & 0xFF));
+            }
+            return swapped;
+        }
+    }
+
+    void swap_mem(std::array<std::uint16_t, Memory::mem_amt> &mem) {
+        if constexpr (!little) {
+            std::ranges::transform(mem, mem.begin(), little_endian<std::uint16_t>);
+        }
+    }
+
+    bool valid(const Header &header) {
+        return header.magic == magic && little_endian(header.version) == version &&
+               little_endian(header.mem_offset) == mem_offset;
+    }
+
+#if defined(__unix__) || defined(__linux__) || defined(__APPLE__)
+    /* Maps memory from the file over the machine's, copy on write so the file never changes */
+    bool map_mem(Machine &m, const int fd) {
+        if constexpr (!little) {
+            return false;
+        }
+        if (static_cast<std::size_t>(sysconf(_SC_PAGESIZE)) != mem_offset || reinterpret_cast<std::uintptr_t>(m.mem.data()) % mem_offset != 0) {
+            return false;
+        }
+        return mmap(m.mem.data(), mem_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, mem_offset) != MAP_FAILED;
+    }
+
+    /* Makes sure what was written to path is on the disk */
+    bool sync(const char *const path) {
+        const int fd { open(path, O_WRONLY) };
+        if (fd < 0) {
+            return false;
+        }
+        const bool synced { fsync(fd) == 0 };
+        close(fd);
+        return synced;
+    }
+#endif
+
+    /* Writes the snapshot to a file of its own */
+    bool write(const Machine &m, const std::string &path, const std::uint64_t executed) {
+        std::ofstream file { path, std::ios::binary | std::ios::trunc };
+        if (!file.is_open()) {
+            return false;
+        }
+
+        std::array<char, mem_offset> page {};
+        Header header { magic, little_endian(version), little_endian<std::uint32_t>(mem_offset), little_endian(executed), {},
+                        little_endian(m.control.get()), little_endian<std::uint64_t>(m.timer.elapsed().count()) };
+        std::ranges::transform(m.regs, header.regs.begin(), little_endian<std::uint16_t>);
+        std::memcpy(page.data(), &header, sizeof(header));
+        file.write(page.data(), page.size());
+
+        auto mem { m.mem };
+        swap_mem(mem);
+        file.write(reinterpret_cast<const char *>(mem.data()), mem_size);
+
+        file.close();
+#if defined(__unix__) || defined(__linux__) || defined(__APPLE__)
+        return file.good() && sync(path.c_str());
+#else
+        return file.good();
+#endif
+    }
+
+}
+
+bool Snapshot::save(const Machine &m, const char *const path, const std::uint64_t executed) {
+    // A machine restored from path may have its memory mapped from it, and truncating
+    // the file would pull those pages out from under it. The new snapshot goes to a
+    // file of its own that then replaces path, which leaves the old one to the mapping.
+    const std::string temp { std::string { path } + ".tmp" };
+    std::error_code error;
+    if (!write(m, temp, executed)) {
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+
+    std::filesystem::rename(temp, path, error);
+    if (error) {
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+    return true;
+}
+
+bool Snapshot::restore(Machine &m, const char *const path, std::uint64_t &executed) {
+    std::ifstream file { path, std::ios::binary };
+    if (!file.is_open()) {
+        return false;
+    }
+
+    Header header {};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || !valid(header)) {
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    if (static_cast<std::size_t>(file.tellg()) < mem_offset + mem_size) {
+        return false;
+    }
+
+    bool mapped { false };
+#if defined(__unix__) || defined(__linux__) || defined(__APPLE__)
+    if (const int fd { open(path, O_RDONLY) }; fd >= 0) {
+        mapped = map_mem(m, fd);
+        close(fd);
+    }
+#endif
+    if (!mapped) {
+        file.seekg(mem_offset);
+        file.read(reinterpret_cast<char *>(m.mem.data()), mem_size);
+        if (!file) {
+            return false;
+        }
+        swap_mem(m.mem);
+    }
+
+    std::ranges::transform(header.regs, m.regs.begin(), little_endian<std::uint16_t>);
+    m.control.set(little_endian(header.mcr));
+    m.timer.resume(std::chrono::milliseconds { little_endian(header.timer) });
+    executed = little_endian(header.executed);
+
+    // Everything decoded belonged to the old memory
+    m.decoded.fill({});
+    return true;
+}
@@ -0,0 +1,38 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_SNAPSHOT_HPP
+#define LC3VM_SNAPSHOT_HPP
+#include <cstdint>
+
+class Machine;
+
+namespace Snapshot {
+
+    /*
+     * A snapshot is a one page header (magic, version, instruction count, the
+     * registers, MCR and how far the timer is into its interval) followed by all of
+     * memory, everything little endian. The other device registers live in memory.
+     * Keys the keyboard has read ahead but the guest has not taken yet are not saved,
+     * they belong to the host's input, and a restored machine reads its own.
+     */
+
+    /*
+     * Writes the machine to path, executed is the number of instructions it has run so
+     * far. The snapshot is written next to path and then renamed over it, so path can
+     * be the snapshot the machine was restored from, and it is never left half written.
+     */
+    bool save(const Machine &, const char *path, std::uint64_t executed);
+
+    /*
+     * Replaces the machine's registers and memory with the snapshot at path. Where it
+     * can, memory is mapped copy on write straight from the file, so restoring costs a
+     * few syscalls and pages are only read when the guest touches them.
+     * executed is set to the instruction count the snapshot was taken at.
+     */
+    bool restore(Machine &, const char *path, std::uint64_t &executed);
+
+}
+
+#endif //LC3VM_SNAPSHOT_HPP
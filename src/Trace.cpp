@@ -0,0 +1,427 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Trace.hpp"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <iterator>
+#include <string>
+#include "Machine.hpp"
+
+namespace {
+
+    constexpr std::array<char, 8> magic { 'L', 'C', '3', 'T', 'R', 'A', 'C', 'E' };
+    constexpr std::uint32_t version { 1 };
+    constexpr std::size_t header_size { magic.size() + sizeof(std::uint32_t) + sizeof(std::uint64_t) };
+
+    enum Tag : std::uint8_t {
+        END,         /* varint instructions since the last checkpoint */
+        FLAGS_CLEAR, /* varint count of readiness results that were clear */
+        FLAGS_SET,   /* varint count of readiness results that were set */
+        KEY,         /* the key */
+        KEY_EOF,
+        CHECKPOINT,  /* varint instructions since the last one, u16 mask of changed registers, their values */
+        INTERRUPTED, /* varint instructions since the last checkpoint, the run stopped there without halting */
+    };
+
+    /* Longest event: a tag, a 10 byte varint, the mask and every register */
+    constexpr std::size_t max_event { 1 + 10 + 2 + 2 * Registers::COUNT };
+
+    /* Appends to a fixed buffer, numbers are little endian */
+    struct Encoder {
+        std::array<std::uint8_t, max_event> bytes {};
+        std::size_t size {};
+
+        void u8(const std::uint8_t val) {
+            bytes[size++] = val;
+        }
+
+        void u16(const std::uint16_t val) {
+            u8(val & 0xFF);
+            u8(val >> 8);
+        }
+
+        void u32(const std::uint32_t val) {
+            u16(val & 0xFFFF);
+            u16(val >> 16);
+        }
+
+        void varint(std::uint64_t val) {
+            while (val >= 0x80) {
+                u8(static_cast<std::uint8_t>(val | 0x80));
+                val >>= 7;
+            }
+            u8(static_cast<std::uint8_t>(val));
+        }
+    };
+
+    /* How much of a trace is complete, and where its recording stopped if it did not halt */
+    struct Extent {
+        std::size_t size;
+        std::optional<std::uint64_t> stop_at; /* Instructions since the start of the recording */
+    };
+
+    /* Walks the events after the header, up to the end of the recording or the first one that was cut off */
+    Extent scan(const std::vector<std::uint8_t> &data) {
+        std::size_t at { header_size };
+        std::uint64_t checkpointed {}; /* Instructions at the last checkpoint */
+
+        // Each reads a part of the event starting at pos, false if the trace ends first
+        const auto varint = [&](std::size_t &pos, std::uint64_t &val) {
+            val = 0;
+            for (unsigned shift {}; pos < data.size() && shift < 64; shift += 7) {
+                const std::uint8_t byte { data[pos++] };
+                val |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        const auto skip = [&](std::size_t &pos, const std::size_t count) {
+            pos += count;
+            return pos <= data.size();
+        };
+
+        while (at < data.size()) {
+            std::size_t pos { at + 1 };
+            std::uint64_t val {};
+            bool complete {};
+            switch (data[at]) {
+                case END:
+                    if (varint(pos, val)) {
+                        return { pos, std::nullopt };
+                    }
+                    break;
+                case INTERRUPTED:
+                    if (varint(pos, val)) {
+                        return { pos, checkpointed + val };
+                    }
+                    break;
+                case FLAGS_CLEAR:
+                case FLAGS_SET:
+                    complete = varint(pos, val);
+                    break;
+                case KEY:
+                    complete = skip(pos, 1);
+                    break;
+                case KEY_EOF:
+                    complete = true;
+                    break;
+                case CHECKPOINT:
+                    if (varint(pos, val) && pos + 2 <= data.size()) {
+                        const auto changed { static_cast<std::uint16_t>(data[pos] | data[pos + 1] << 8) };
+                        complete = skip(pos, 2 + 2 * static_cast<std::size_t>(std::popcount(changed)));
+                        checkpointed += complete ? val : 0;
+                    }
+                    break;
+                default:
+                    break;
+            }
+            if (!complete) {
+                break;
+            }
+            at = pos;
+        }
+        return { at, checkpointed };
+    }
+
+    /* FNV-1a over memory and registers, which is what a replay has to start from */
+    std::uint64_t checksum(const Machine &m) {
+        std::uint64_t hash { 0xCBF29CE484222325 };
+        const auto add = [&](const std::uint16_t word) {
+            for (const std::uint8_t byte : { static_cast<std::uint8_t>(word & 0xFF), static_cast<std::uint8_t>(word >> 8) }) {
+                hash = (hash ^ byte) * 0x100000001B3;
+            }
+        };
+        for (const std::uint16_t word : m.mem) {
+            add(word);
+        }
+        for (const std::uint16_t reg : m.regs) {
+            add(reg);
+        }
+        return hash;
+    }
+
+}
+
+Trace::Trace(const Mode mode) : mode { mode } {}
+
+std::unique_ptr<Trace> Trace::record(const char *const path) {
+    std::unique_ptr<Trace> trace { new Trace { RECORD } };
+    trace->file.open(path, std::ios::binary | std::ios::trunc);
+    if (!trace->file.is_open()) {
+        return nullptr;
+    }
+    trace->ring = std::make_unique<std::uint8_t[]>(capacity);
+    trace->writer = std::thread { &Trace::write_output, trace.get() };
+    return trace;
+}
+
+std::unique_ptr<Trace> Trace::replay(const char *const path) {
+    std::ifstream file { path, std::ios::binary };
+    if (!file.is_open()) {
+        return nullptr;
+    }
+
+    std::unique_ptr<Trace> trace { new Trace { REPLAY } };
+    trace->data.assign(std::istreambuf_iterator<char> { file }, std::istreambuf_iterator<char> {});
+    if (trace->data.size() < header_size || !std::equal(magic.begin(), magic.end(), trace->data.begin())) {
+        return nullptr;
+    }
+
+    // Whatever follows the last complete event is what the recorder was writing when it died
+    const Extent extent { scan(trace->data) };
+    trace->data.resize(extent.size);
+    trace->stop_at = extent.stop_at;
+    return trace;
+}
+
+Trace::~Trace() {
+    close();
+}
+
+void Trace::close() {
+    if (mode == RECORD && writer.joinable()) {
+        flush_flags();
+        closing.store(true, std::memory_order_release);
+        writer.join();
+    }
+}
+
+bool Trace::begin(const Machine &m, const std::uint64_t executed) {
+    regs = m.regs;
+    executed_at = executed;
+
+    Encoder header;
+    for (const char c : magic) {
+        header.u8(static_cast<std::uint8_t>(c));
+    }
+    header.u32(version);
+    const std::uint64_t sum { checksum(m) };
+    for (std::size_t i {}; i < sizeof(sum); ++i) {
+        header.u8(static_cast<std::uint8_t>(sum >> 8 * i));
+    }
+
+    if (mode == RECORD) {
+        put(header.bytes.data(), header.size);
+        return true;
+    }
+    cursor = header_size;
+    if (stop_at) {
+        *stop_at += executed;
+    }
+    return std::equal(header.bytes.begin(), header.bytes.begin() + header_size, data.begin());
+}
+
+void Trace::checkpoint(const Machine &m, const std::uint64_t executed) {
+    if (mode == RECORD) {
+        flush_flags();
+
+        Encoder event;
+        event.u8(CHECKPOINT);
+        event.varint(executed - executed_at);
+        std::uint16_t changed {};
+        for (std::size_t i {}; i < regs.size(); ++i) {
+            changed |= (m.regs[i] != regs[i]) << i;
+        }
+        event.u16(changed);
+        for (std::size_t i {}; i < regs.size(); ++i) {
+            if (changed >> i & 1) {
+                event.u16(m.regs[i]);
+            }
+        }
+        put(event.bytes.data(), event.size);
+    } else if (!diverged()) {
+        if (flag_run != 0 || !next_event(CHECKPOINT) || read_varint() != executed - executed_at) {
+            diverge(executed);
+            return;
+        }
+        const std::uint16_t changed { read_u16() };
+        for (std::size_t i {}; i < regs.size(); ++i) {
+            if (changed >> i & 1) {
+                regs[i] = read_u16();
+            }
+        }
+        if (regs != m.regs) {
+            diverge(executed);
+            return;
+        }
+    }
+
+    regs = m.regs;
+    executed_at = executed;
+}
+
+void Trace::end(const std::uint64_t executed) {
+    if (mode == RECORD) {
+        flush_flags();
+
+        Encoder event;
+        event.u8(END);
+        event.varint(executed - executed_at);
+        put(event.bytes.data(), event.size);
+    } else if (!diverged()) {
+        if (flag_run != 0 || !next_event(END) || read_varint() != executed - executed_at) {
+            diverge(executed);
+        }
+    }
+}
+
+void Trace::interrupt(const std::uint64_t executed) {
+    if (mode == RECORD) {
+        flush_flags();
+
+        Encoder event;
+        event.u8(INTERRUPTED);
+        event.varint(executed - executed_at);
+        put(event.bytes.data(), event.size);
+    }
+}
+
+void Trace::log_flag(const bool val) {
+    if (flag_run != 0 && val != flag_val) {
+        flush_flags();
+    }
+    flag_val = val;
+    ++flag_run;
+}
+
+void Trace::log_key(const int c) {
+    flush_flags();
+
+    Encoder event;
+    if (c == std::char_traits<char>::eof()) {
+        event.u8(KEY_EOF);
+    } else {
+        event.u8(KEY);
+        event.u8(static_cast<std::uint8_t>(c));
+    }
+    put(event.bytes.data(), event.size);
+}
+
+void Trace::flush_flags() {
+    if (flag_run == 0) {
+        return;
+    }
+    Encoder event;
+    event.u8(flag_val ? FLAGS_SET : FLAGS_CLEAR);
+    event.varint(flag_run);
+    put(event.bytes.data(), event.size);
+    flag_run = 0;
+}
+
+void Trace::put(const std::uint8_t *const bytes, const std::size_t count) {
+    const std::size_t start { head.load(std::memory_order_relaxed) };
+
+    // The writer is far behind only if the disk is, waiting is the only way not to lose events
+    while (start + count - tail.load(std::memory_order_acquire) > capacity) [[unlikely]] {
+        std::this_thread::yield();
+    }
+
+    for (std::size_t i {}; i < count; ++i) {
+        ring[(start + i) % capacity] = bytes[i];
+    }
+    head.store(start + count, std::memory_order_release);
+}
+
+void Trace::write_output() {
+    // The ring is checked this often when it is empty, the guest thread never has to wake the writer
+    constexpr std::chrono::milliseconds idle { 1 };
+
+    std::size_t written { tail.load(std::memory_order_relaxed) };
+    std::size_t flushed { written };
+    while (true) {
+        const std::size_t available { head.load(std::memory_order_acquire) };
+        if (available == written) {
+            // closing is set after the last put, so once it is seen head is final
+            if (closing.load(std::memory_order_acquire) && head.load(std::memory_order_acquire) == written) {
+                break;
+            }
+            // Caught up, so a recorder that is killed now leaves everything logged so far
+            if (flushed != written) {
+                file.flush();
+                flushed = written;
+            }
+            std::this_thread::sleep_for(idle);
+            continue;
+        }
+
+        const std::size_t start { written % capacity };
+        const std::size_t count { std::min(available - written, capacity - start) };
+        file.write(reinterpret_cast<const char *>(&ring[start]), static_cast<std::streamsize>(count));
+        written += count;
+        tail.store(written, std::memory_order_release);
+    }
+    file.flush();
+}
+
+bool Trace::next_flag() {
+    if (diverged()) {
+        // Keys read from here on are EOF, like a script that ran out
+        return true;
+    }
+    if (flag_run == 0) {
+        if (cursor < data.size() && (data[cursor] == FLAGS_CLEAR || data[cursor] == FLAGS_SET)) {
+            flag_val = data[cursor++] == FLAGS_SET;
+            flag_run = read_varint();
+        }
+        if (flag_run == 0) {
+            diverge(executed_at);
+            return true;
+        }
+    }
+    --flag_run;
+    return flag_val;
+}
+
+int Trace::next_key() {
+    if (!diverged() && flag_run == 0) {
+        if (next_event(KEY) && cursor < data.size()) {
+            return data[cursor++];
+        }
+        if (next_event(KEY_EOF)) {
+            return std::char_traits<char>::eof();
+        }
+    }
+    diverge(executed_at);
+    return std::char_traits<char>::eof();
+}
+
+bool Trace::next_event(const std::uint8_t tag) {
+    if (cursor < data.size() && data[cursor] == tag) {
+        ++cursor;
+        return true;
+    }
+    return false;
+}
+
+std::uint16_t Trace::read_u16() {
+    if (data.size() - cursor < sizeof(std::uint16_t)) {
+        cursor = data.size();
+        return 0;
+    }
+    const auto val { static_cast<std::uint16_t>(data[cursor] | data[cursor + 1] << 8) };
+    cursor += sizeof(std::uint16_t);
+    return val;
+}
+
+std::uint64_t Trace::read_varint() {
+    std::uint64_t val {};
+    for (unsigned shift {}; cursor < data.size() && shift < 64; shift += 7) {
+        const std::uint8_t byte { data[cursor++] };
+        val |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    return val;
+}
+
+void Trace::diverge(const std::uint64_t executed) {
+    if (!diverged_at) {
+        diverged_at = executed;
+    }
+}
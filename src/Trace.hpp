@@ -0,0 +1,155 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_TRACE_HPP
+#define LC3VM_TRACE_HPP
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "Registers.hpp"
+
+class Machine;
+
+/*
+ * A record of everything a run depends on besides its images: each KBSR and TMR
+ * readiness result and each key the guest read, in the order the guest saw them.
+ * Replaying hands the guest the recorded values instead of the live ones, so the
+ * run repeats exactly, and the register checkpoints taken every checkpoint_interval
+ * instructions catch a replay that went a different way.
+ *
+ * The file is a header (magic, version and a checksum of the starting memory and
+ * registers) followed by tagged events. Readiness results are stored as runs of
+ * equal values, instruction counts as varint deltas from the previous checkpoint
+ * and checkpoints only hold the registers that changed. While recording, events
+ * go into a lock free ring that a background thread writes to the file, so the
+ * guest thread never waits for the disk, and the file is flushed whenever the ring
+ * runs empty. A trace that was cut short (the recorder was killed) still replays, up
+ * to its last checkpoint.
+ */
+class Trace {
+public:
+    static constexpr std::uint64_t checkpoint_interval { 1 << 20 };
+
+    /* nullptr if path cannot be opened (or for replay, is not a trace) */
+    static std::unique_ptr<Trace> record(const char *path);
+    static std::unique_ptr<Trace> replay(const char *path);
+
+    ~Trace();
+
+    /* Recording: writes out everything logged so far and stops the writer, nothing can be logged after */
+    void close();
+
+    Trace(const Trace &) = delete;
+    Trace &operator=(const Trace &) = delete;
+
+    bool replaying() const {
+        return mode == REPLAY;
+    }
+
+    /*
+     * Marks where the run starts, after the images are loaded. Recording writes the
+     * header, replay checks that the machine matches the recorded one.
+     */
+    bool begin(const Machine &, std::uint64_t executed);
+
+    /* A device status bit. Recording logs live() and returns it, replay returns the recorded value without calling live */
+    template <typename Live>
+    bool flag(Live &&live) {
+        if (mode == REPLAY) {
+            return next_flag();
+        }
+        const bool val { live() };
+        log_flag(val);
+        return val;
+    }
+
+    /* A key (or EOF), the same way as flag */
+    template <typename Live>
+    int key(Live &&live) {
+        if (mode == REPLAY) {
+            return next_key();
+        }
+        const int c { live() };
+        log_key(c);
+        return c;
+    }
+
+    /* Recording logs the registers, replay compares them with the recorded ones */
+    void checkpoint(const Machine &, std::uint64_t executed);
+
+    /* The run halted after executed instructions */
+    void end(std::uint64_t executed);
+
+    /* Recording: the run was interrupted after executed instructions, before it halted */
+    void interrupt(std::uint64_t executed);
+
+    /* Replay: where the recording stopped without halting, if it was interrupted or cut short */
+    std::optional<std::uint64_t> stops_at() const {
+        return stop_at;
+    }
+
+    /* Whether the replay stopped matching the recording, and the instruction count it was first noticed at */
+    bool diverged() const {
+        return diverged_at.has_value();
+    }
+
+    std::uint64_t divergence() const {
+        return diverged_at.value_or(0);
+    }
+
+private:
+    enum Mode {
+        RECORD,
+        REPLAY,
+    };
+
+    explicit Trace(Mode mode);
+
+    /* Recording */
+    void log_flag(bool val);
+    void log_key(int c);
+    void flush_flags();
+    void put(const std::uint8_t *bytes, std::size_t count);
+    void write_output();
+
+    /* Replay */
+    bool next_flag();
+    int next_key();
+    bool next_event(std::uint8_t tag);
+    std::uint64_t read_varint();
+    std::uint16_t read_u16();
+    void diverge(std::uint64_t executed);
+
+    const Mode mode;
+
+    std::array<std::uint16_t, Registers::COUNT> regs {}; /* At the last checkpoint */
+    std::uint64_t executed_at {};                        /* Instructions run at the last checkpoint */
+
+    /* The run of equal readiness results not logged yet, or being replayed */
+    bool flag_val {};
+    std::uint64_t flag_run {};
+
+    /* Recording: the ring between the guest thread and the writer */
+    static constexpr std::size_t capacity { 1 << 20 };
+    std::unique_ptr<std::uint8_t[]> ring;
+    alignas(64) std::atomic<std::size_t> head {};
+    alignas(64) std::atomic<std::size_t> tail {};
+    std::atomic<bool> closing { false };
+    std::ofstream file;
+    std::thread writer;
+
+    /* Replay: the whole file and where the next event starts */
+    std::vector<std::uint8_t> data;
+    std::size_t cursor {};
+    std::optional<std::uint64_t> diverged_at;
+    std::optional<std::uint64_t> stop_at;
+};
+
+#endif //LC3VM_TRACE_HPP
@@ -3,14 +3,94 @@
 //
 
 #include "Trap.hpp"
-#include "Memory.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <optional>
+#include <string_view>
+#include "Machine.hpp"
 #include "Opcodes.hpp"
 #include "Registers.hpp"
 #include "PlatformSpecific.hpp"
+#include "Trace.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define LC3VM_SIMD_SCAN 1
+#else
+#define LC3VM_SIMD_SCAN 0
+#endif
+
+namespace {
+
+    std::size_t find_nul_scalar(const std::uint16_t *const mem, std::size_t i, const std::size_t end) {
+        while (i < end && mem[i] != 0) {
+            ++i;
+        }
+        return i;
+    }
+
+#if LC3VM_SIMD_SCAN
+    /* Compares 8 words at a time against zero, SSE2 is part of x86-64 so it needs no check */
+    std::size_t find_nul_sse2(const std::uint16_t *const mem, std::size_t i, const std::size_t end) {
+        const __m128i zero { _mm_setzero_si128() };
+        for (; i + 8 <= end; i += 8) {
+            const __m128i words { _mm_loadu_si128(reinterpret_cast<const __m128i *>(mem + i)) };
+            if (const int mask { _mm_movemask_epi8(_mm_cmpeq_epi16(words, zero)) }) {
+                return i + std::countr_zero(static_cast<unsigned>(mask)) / 2;
+            }
+        }
+        return find_nul_scalar(mem, i, end);
+    }
+
+    __attribute__((target("avx2")))
+    std::size_t find_nul_avx2(const std::uint16_t *const mem, std::size_t i, const std::size_t end) {
+        const __m256i zero { _mm256_setzero_si256() };
+        for (; i + 16 <= end; i += 16) {
+            const __m256i words { _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mem + i)) };
+            if (const int mask { _mm256_movemask_epi8(_mm256_cmpeq_epi16(words, zero)) }) {
+                return i + std::countr_zero(static_cast<unsigned>(mask)) / 2;
+            }
+        }
+        return find_nul_scalar(mem, i, end);
+    }
+#endif
+
+    /* Index of the first zero word in mem[start, end), or end if there is none */
+    std::size_t find_nul(const std::uint16_t *const mem, const std::size_t start, const std::size_t end) {
+#if LC3VM_SIMD_SCAN
+        static const auto find { __builtin_cpu_supports("avx2") ? &find_nul_avx2 : &find_nul_sse2 };
+        return find(mem, start, end);
+#else
+        return find_nul_scalar(mem, start, end);
+#endif
+    }
+
+    /*
+     * Finds the end of the string at addr without going through Machine::read. Strings
+     * that reach the I/O region, where reads go to devices, return nothing and are
+     * printed a word at a time instead (this includes every string that wraps).
+     */
+    std::optional<std::uint16_t> find_string_end(const Machine &m, const std::uint16_t addr) {
+        const std::size_t end { find_nul(m.mem.data(), addr, Memory::io_start) };
+        if (end >= Memory::io_start) {
+            return std::nullopt;
+        }
+        return static_cast<std::uint16_t>(end);
+    }
+
+    /* Strings are converted to bytes in chunks this big, which covers almost every string in one write */
+    constexpr std::size_t chunk_size { 4096 };
+
+}
 
 /* Reads a character and returns it */
-unsigned char read_char() {
-    const unsigned char c ( std::cin.get() );
+unsigned char read_char(Machine &m) {
+    m.display.input_requested();
+    const auto get = [&] {
+        return m.keyboard.get();
+    };
+    const unsigned char c ( m.trace ? m.trace->key(get) : get() );
 
     // no std::cin.ignore() because we already disabled the buffer earlier
 
@@ -18,54 +98,80 @@ unsigned char read_char() {
 }
 
 template <>
-void Trap::exec<Trap::PUTS>() {
+void Trap::exec<Trap::PUTS>(Machine &m) {
     // String's starting address is in register 0
-    std::uint16_t addr { Registers::read(Registers::R0) };
+    std::uint16_t addr { m.read_reg(Registers::R0) };
 
-    while (Memory::read(addr) != 0x0) {
-        std::cout << static_cast<unsigned char>(Memory::read(addr++));
+    const auto end { find_string_end(m, addr) };
+    if (!end) {
+        while (m.read(addr) != 0x0) {
+            m.display.put(static_cast<char>(m.read(addr++)));
+        }
+        return;
     }
 
-    std::cout << std::flush;
+    // One character per word, the high byte is ignored
+    std::array<char, chunk_size> chars;
+    while (addr < *end) {
+        const std::size_t count { std::min<std::size_t>(*end - addr, chunk_size) };
+        std::transform(&m.mem[addr], &m.mem[addr] + count, chars.begin(),
+                       [](const std::uint16_t word) { return static_cast<char>(word); });
+        m.display.write(chars.data(), count);
+        addr += count;
+    }
 }
 
 /* Outputs a single character located in register 0 */
 template <>
-void Trap::exec<Trap::OUT>() {
-    std::cout << static_cast<unsigned char>(Registers::read(Registers::R0)) << std::flush;
+void Trap::exec<Trap::OUT>(Machine &m) {
+    m.display.put(static_cast<char>(m.read_reg(Registers::R0)));
 }
 
 template<>
-void Trap::exec<Trap::IN>() {
-    std::cout << "Enter a character: ";
-    const unsigned char c ( read_char() );
-    std::cout << c << std::flush;
+void Trap::exec<Trap::IN>(Machine &m) {
+    m.display.write(in_prompt.data(), in_prompt.size());
+    const unsigned char c ( read_char(m) );
+    m.display.put(static_cast<char>(c));
 
-    Registers::write(Registers::R0, c);
-    Opcodes::update_cond(Registers::R0);
+    m.write_reg(Registers::R0, c);
+    Opcodes::update_cond(m, Registers::R0);
 }
 
 template<>
-void Trap::exec<Trap::PUTSP>() {
-    std::uint16_t addr { Registers::read(Registers::R0) };
+void Trap::exec<Trap::PUTSP>(Machine &m) {
+    std::uint16_t addr { m.read_reg(Registers::R0) };
 
-    while (Memory::read(addr) != 0x0) {
-        const std::uint16_t chars { Memory::read(addr) };
-        const unsigned char char1 ( chars & 0xFF );
-        const unsigned char char2 ( chars >> 8 );
-
-        std::cout << char1;
-        if (char2) {
-            std::cout << char2;
+    const auto end { find_string_end(m, addr) };
+    if (!end) {
+        while (m.read(addr) != 0x0) {
+            putsp_chars(m.read(addr), [&](const char c) { m.display.put(c); });
+            ++addr;
         }
+        return;
+    }
 
-        ++addr;
+    // Up to two characters per word
+    std::array<char, 2 * chunk_size> chars;
+    while (addr < *end) {
+        const std::size_t count { std::min<std::size_t>(*end - addr, chunk_size) };
+        std::size_t size {};
+        for (std::size_t i {}; i < count; ++i) {
+            putsp_chars(m.mem[addr + i], [&](const char c) { chars[size++] = c; });
+        }
+        m.display.write(chars.data(), size);
+        addr += count;
     }
-    std::cout << std::flush;
 }
 
 template <>
-void Trap::exec<Trap::GETC>() {
-    Registers::write(Registers::R0, read_char());
-    Opcodes::update_cond(Registers::R0);
-}
\ No newline at end of file
+void Trap::exec<Trap::GETC>(Machine &m) {
+    m.write_reg(Registers::R0, read_char(m));
+    Opcodes::update_cond(m, Registers::R0);
+}
+
+/* Only prints the halt message, stopping execution is up to the interpreter */
+template <>
+void Trap::exec<Trap::HALT>(Machine &m) {
+    m.display.write(halt_message.data(), halt_message.size());
+    m.display.halted();
+}
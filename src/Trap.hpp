@@ -4,7 +4,11 @@
 
 #ifndef LC3VM_TRAP_HPP
 #define LC3VM_TRAP_HPP
+#include <cstdint>
 #include <iostream>
+#include <string_view>
+
+class Machine;
 
 namespace Trap {
 
@@ -18,29 +22,44 @@ namespace Trap {
         COUNT = 0x6, /* Count of all Trap Codes */
     };
 
+    /* What IN prints before it reads a key */
+    constexpr std::string_view in_prompt { "Enter a character: " };
+
+    /* What HALT prints */
+    constexpr std::string_view halt_message { "\n** Program Halted **\n" };
+
+    /* Hands the characters of a PUTSP word to put: the low byte, then the high byte unless it is an odd string's padding */
+    template <typename Put>
+    void putsp_chars(const std::uint16_t word, Put &&put) {
+        put(static_cast<char>(word & 0xFF));
+        if (word >> 8) {
+            put(static_cast<char>(word >> 8));
+        }
+    }
+
     template <decltype(COUNT + 0) trap_code>
-    void exec() {
+    void exec(Machine &) {
         std::cout << "Invalid Trap Code: " << trap_code << '\n';
         std::abort();
     };
 
     template <>
-    void exec<GETC>();
+    void exec<GETC>(Machine &);
 
     template <>
-    void exec<OUT>();
+    void exec<OUT>(Machine &);
 
     template <>
-    void exec<PUTS>();
+    void exec<PUTS>(Machine &);
 
     template <>
-    void exec<IN>();
+    void exec<IN>(Machine &);
 
     template <>
-    void exec<PUTSP>();
+    void exec<PUTSP>(Machine &);
 
     template <>
-    void exec<HALT>();
+    void exec<HALT>(Machine &);
 
 }
 
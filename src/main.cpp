@@ -1,102 +1,553 @@
-#include "Registers.hpp"
-#include "Opcodes.hpp"
-#include <bit>
-#include <cstdint>
+#include "Batch.hpp"
+#include "Counters.hpp"
+#include "Debugger.hpp"
+#include "ForkServer.hpp"
+#include "Host.hpp"
+#include "Image.hpp"
+#include "Interpreter.hpp"
+#include "Jit.hpp"
+#include "Machine.hpp"
+#include "Notation.hpp"
+#include "PlatformSpecific.hpp"
+#include "Profile.hpp"
+#include "Snapshot.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <chrono>
 #include <csignal>
-#include "Trap.hpp"
+#include <cstdint>
 #include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+void handle_interrupt(const int _) {
+    restore_input_buffering();
+    std::cout << "\n** Program Terminated **\n";
+    std::exit(-2);
+}
 
-/* Reads a binary containing the instructions to execute into memory */
-bool read_image(const char *const filename) {
-    std::ifstream file_stream {filename, std::ios::binary};
+using Notation::parse_number;
 
-    if (file_stream.bad() || !file_stream.is_open()) {
-        return false;
+/* Where --snapshot-at stops the program, either before the instruction at a PC or after a number of instructions */
+struct SnapshotPoint {
+    std::optional<std::uint16_t> pc;
+    std::optional<std::uint64_t> count;
+};
+
+std::optional<SnapshotPoint> parse_snapshot_point(const std::string_view point) {
+    if (point.starts_with("pc:")) {
+        if (const auto pc { parse_number<std::uint16_t>(point.substr(3)) }) {
+            return SnapshotPoint { pc, std::nullopt };
+        }
+    } else if (point.starts_with("count:")) {
+        if (const auto count { parse_number<std::uint64_t>(point.substr(6)) }) {
+            return SnapshotPoint { std::nullopt, count };
+        }
     }
+    return std::nullopt;
+}
 
-    // where to place the program in memory
-    std::uint16_t start_addr {};
-    file_stream.read(reinterpret_cast<char *>(&start_addr), sizeof(std::uint16_t));
+/* Display flush policy from --flush, a comma separated list of newline, input, halt and a byte count */
+struct FlushPolicy {
+    std::uint8_t policy {};
+    std::size_t every { Display::capacity };
+};
 
-    if (file_stream.bad())
-        return false;
+std::optional<FlushPolicy> parse_flush_policy(std::string_view list) {
+    FlushPolicy flush {};
+    while (!list.empty()) {
+        const std::size_t comma { std::min(list.find(','), list.size()) };
+        const std::string_view item { list.substr(0, comma) };
+        list.remove_prefix(std::min(comma + 1, list.size()));
 
-    // Because all lc3 programs are in big endian, we must swap to little if we are little endian
-    if constexpr (std::endian::native == std::endian::little) {
-        start_addr = start_addr << 8 | start_addr >> 8;
+        if (item == "newline") {
+            flush.policy |= Display::ON_NEWLINE;
+        } else if (item == "input") {
+            flush.policy |= Display::ON_INPUT;
+        } else if (item == "halt") {
+            flush.policy |= Display::ON_HALT;
+        } else if (const auto every { parse_number<std::size_t>(item) }) {
+            flush.every = *every;
+        } else {
+            return std::nullopt;
+        }
     }
+    return flush;
+}
 
+/* While recording, Ctrl-C stops the run where it is, so the trace can be ended there */
+void interrupt_recording(int) {
+    Interpreter::interrupt();
+}
 
-    // Amount of memory to read in std::uint16_t(s)
-    const auto to_read { static_cast<std::streamsize>(Memory::mem_amt - start_addr) };
+/*
+ * Interprets up to budget instructions like Interpreter::run. While tracing it also
+ * stops at every multiple of Trace::checkpoint_interval instructions to checkpoint,
+ * so a recording and its replay checkpoint at the same counts however they got
+ * there. executed counts the instructions run so far.
+ *
+ * Returns PREEMPTED when a recording was interrupted, or when a replay got to where
+ * its recording stopped without halting.
+ */
+Interpreter::Stop run_counted(Machine &m, std::uint64_t budget, std::uint64_t &executed) {
+    while (true) {
+        std::uint64_t slice { budget };
+        if (m.trace) {
+            slice = std::min(slice, Trace::checkpoint_interval - executed % Trace::checkpoint_interval);
+            if (const auto stop_at { m.trace->stops_at() }) {
+                slice = std::min(slice, *stop_at - executed);
+            }
+        }
 
-    // Read rest of the program
-    file_stream.read(
-        reinterpret_cast<char *>(&Memory::mem[start_addr]),
-        static_cast<std::streamsize>(to_read * sizeof(std::uint16_t)) // convert to bytes
-    );
+        const std::uint64_t start_slice { slice };
+        const Interpreter::Stop stop { Interpreter::run(m, slice) };
+        executed += start_slice - slice;
+        budget -= start_slice - slice;
 
-    if (file_stream.bad()) {
-        return false;
+        if (m.trace && stop == Interpreter::OUT_OF_BUDGET && slice == 0
+            && executed % Trace::checkpoint_interval == 0) {
+            m.trace->checkpoint(m, executed);
+        }
+        if (stop == Interpreter::OUT_OF_BUDGET
+            && (Interpreter::interrupted() || (m.trace && m.trace->stops_at() == executed))) {
+            return Interpreter::PREEMPTED;
+        }
+        if (stop != Interpreter::OUT_OF_BUDGET || budget == 0) {
+            return stop;
+        }
     }
+}
 
-    // Swap rest of memory to little endian if needed
-    if constexpr (std::endian::native == std::endian::little) {
-        for ( std::size_t i { start_addr }; i <= start_addr + to_read; ++i ) {
-            Memory::mem[i] = Memory::mem[i] << 8 | Memory::mem[i] >> 8;
+/*
+ * Ends a traced run that stopped without halting. An interrupted recording ends its
+ * trace there and exits like handle_interrupt, a replay stops where its recording did.
+ */
+[[noreturn]] void stop_traced(Machine &m, const std::uint64_t executed, const bool headless) {
+    m.display.flush();
+    if (m.trace->replaying()) {
+        if (m.trace->diverged()) {
+            std::cout << "** Replay diverged from the recording by instruction " << m.trace->divergence() << " **\n";
         }
+        std::cout << "\n** Replay reached the end of the recording after " << executed << " instructions **\n";
+        std::exit(0);
+    }
+
+    m.trace->interrupt(executed);
+    m.trace->close();
+    if (!headless) {
+        restore_input_buffering();
+    }
+    std::cout << "\n** Program Terminated **\n";
+    std::exit(-2);
+}
+
+/* Ends the trace like HALT would, then panics with the faulting instruction */
+[[noreturn]] void fault(Machine &m, const std::uint64_t executed) {
+    if (m.trace) {
+        m.trace->end(executed);
+        m.trace->close();
+    }
+    Interpreter::panic(m);
+}
+
+/*
+ * Interprets the program until the snapshot point and saves it there. Returns false
+ * if the program halted first. executed counts the instructions run so far.
+ */
+bool run_to_snapshot(Machine &m, const SnapshotPoint &point, const char *const path, std::uint64_t &executed,
+                     const bool headless) {
+    std::uint64_t budget { std::numeric_limits<std::uint64_t>::max() };
+    if (point.count) {
+        budget = *point.count > executed ? *point.count - executed : 0;
+    }
+    if (point.pc) {
+        Interpreter::set_breakpoint(m, *point.pc);
     }
 
-    file_stream.close();
+    const Interpreter::Stop stop { run_counted(m, budget, executed) };
+    if (stop == Interpreter::FAULTED) {
+        fault(m, executed);
+    }
+    if (stop == Interpreter::PREEMPTED) {
+        stop_traced(m, executed, headless);
+    }
 
+    if (point.pc) {
+        Interpreter::clear_breakpoint(m, *point.pc);
+    }
+
+    if (stop == Interpreter::HALTED) {
+        return false;
+    }
+
+    if (!Snapshot::save(m, path, executed)) {
+        std::cout << "** Failed to write snapshot **\n";
+    }
     return true;
 }
 
-void handle_interrupt(const int _) {
-    restore_input_buffering();
-    std::cout << "\n** Program Terminated **\n";
-    std::exit(-2);
+/*
+ * Interprets the program until it halts or uses up its quota. A program that uses it
+ * up is suspended: it is saved to a snapshot where it stopped, and restoring that
+ * snapshot carries on from there. executed counts the instructions run so far.
+ */
+void run_limited(Machine &m, const Interpreter::Quota &quota, const char *const path, std::uint64_t &executed) {
+    const Interpreter::Stop stop { Interpreter::run(m, quota, executed) };
+    if (stop == Interpreter::FAULTED) {
+        Interpreter::panic(m);
+    }
+    if (stop != Interpreter::PREEMPTED) {
+        return;
+    }
+
+    // What the program printed so far comes before the notice
+    m.display.flush();
+    if (!Snapshot::save(m, path, executed)) {
+        std::cout << "** Failed to write snapshot **\n";
+        return;
+    }
+    std::cout << "\n** Program suspended after " << executed << " instructions **\n";
 }
 
 int main(const int argc, const char *const argv[]) {
 
-    if (argc != 2) {
-        std::cout << "Usage: lc3vm [path to image file]\n";
+    std::vector<const char *> images;
+    bool use_jit { false };
+    bool usage { false };
+    const char *restore_path { nullptr };
+    const char *snapshot_path { "lc3vm.snap" };
+    std::optional<SnapshotPoint> snapshot_at;
+    std::optional<FlushPolicy> flush;
+    bool headless { false };
+    const char *input_path { nullptr };
+    const char *output_path { nullptr };
+    const char *profile_path { nullptr };
+    bool counters { false };
+    const char *batch_path { nullptr };
+    const char *record_path { nullptr };
+    const char *replay_path { nullptr };
+    bool debug { false };
+    std::optional<std::uint64_t> limit;
+    std::optional<std::chrono::milliseconds> time_limit;
+    std::optional<std::uint16_t> serve_port;
+    const char *fork_server_path { nullptr };
+    std::optional<std::uint16_t> fork_at;
+    Batch::Options batch_options {};
+
+    for (int i { 1 }; i < argc; ++i) {
+        const std::string_view arg { argv[i] };
+
+        if (arg == "--engine=interp") {
+            use_jit = false;
+            batch_options.lockstep = false;
+        } else if (arg == "--engine=jit") {
+            use_jit = true;
+            batch_options.lockstep = false;
+        } else if (arg == "--engine=lockstep") {
+            use_jit = false;
+            batch_options.lockstep = true;
+        } else if (arg.starts_with("--restore=")) {
+            restore_path = argv[i] + arg.find('=') + 1;
+        } else if (arg.starts_with("--snapshot=")) {
+            snapshot_path = argv[i] + arg.find('=') + 1;
+        } else if (arg.starts_with("--snapshot-at=")) {
+            snapshot_at = parse_snapshot_point(arg.substr(arg.find('=') + 1));
+            usage = usage || !snapshot_at;
+        } else if (arg.starts_with("--flush=")) {
+            flush = parse_flush_policy(arg.substr(arg.find('=') + 1));
+            usage = usage || !flush;
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg.starts_with("--input=")) {
+            input_path = argv[i] + arg.find('=') + 1;
+            headless = true;
+        } else if (arg.starts_with("--output=")) {
+            output_path = argv[i] + arg.find('=') + 1;
+            headless = true;
+        } else if (arg == "--profile") {
+            profile_path = "lc3vm-profile.json";
+        } else if (arg.starts_with("--profile=")) {
+            profile_path = argv[i] + arg.find('=') + 1;
+        } else if (arg == "--counters") {
+            counters = true;
+        } else if (arg.starts_with("--record=")) {
+            record_path = argv[i] + arg.find('=') + 1;
+        } else if (arg.starts_with("--replay=")) {
+            replay_path = argv[i] + arg.find('=') + 1;
+            headless = true;
+        } else if (arg == "--debug") {
+            debug = true;
+            headless = true;
+        } else if (arg.starts_with("--serve=")) {
+            serve_port = parse_number<std::uint16_t>(arg.substr(arg.find('=') + 1));
+            usage = usage || !serve_port;
+            headless = true;
+        } else if (arg.starts_with("--fork-server=")) {
+            fork_server_path = argv[i] + arg.find('=') + 1;
+            headless = true;
+        } else if (arg.starts_with("--fork-at=")) {
+            fork_at = parse_number<std::uint16_t>(arg.substr(arg.find('=') + 1));
+            usage = usage || !fork_at;
+        } else if (arg.starts_with("--batch=")) {
+            batch_path = argv[i] + arg.find('=') + 1;
+        } else if (arg.starts_with("--jobs=")) {
+            const auto threads { parse_number<unsigned>(arg.substr(arg.find('=') + 1)) };
+            batch_options.threads = threads.value_or(0);
+            usage = usage || !threads;
+        } else if (arg.starts_with("--limit=")) {
+            limit = parse_number<std::uint64_t>(arg.substr(arg.find('=') + 1));
+            usage = usage || !limit;
+        } else if (arg.starts_with("--time-limit=")) {
+            const auto ms { parse_number<std::uint64_t>(arg.substr(arg.find('=') + 1)) };
+            time_limit = std::chrono::milliseconds { ms.value_or(0) };
+            usage = usage || !ms;
+        } else if (!arg.starts_with("--")) {
+            images.push_back(argv[i]);
+        } else {
+            usage = true;
+        }
+    }
+
+    /* Host counters go into a profile */
+    if (counters && !profile_path) {
+        profile_path = "lc3vm-profile.json";
+    }
+
+    if (usage || (images.empty() && !restore_path && !batch_path) || (batch_options.lockstep && !batch_path)
+        || (record_path && replay_path)
+        || (profile_path && (record_path || replay_path))
+        || (debug && (profile_path || record_path || replay_path || snapshot_at))
+        || ((limit || time_limit) && !batch_path && (debug || profile_path || record_path || replay_path || snapshot_at))
+        || (time_limit && batch_path)
+        || (serve_port && (batch_path || debug || profile_path || record_path || replay_path || snapshot_at
+                           || limit || time_limit))
+        || (fork_server_path && (batch_path || serve_port || debug || profile_path || record_path || replay_path
+                                 || snapshot_at || limit || time_limit || input_path || output_path))
+        || (fork_at && !fork_server_path)) {
+        std::cout << "Usage: lc3vm [--engine=interp|jit] [--snapshot-at=pc:ADDR|count:N [--snapshot=FILE]]\n"
+                     "             [--restore=FILE] [--flush=newline,input,halt,BYTES]\n"
+                     "             [--headless] [--input=FILE] [--output=FILE] [--profile[=FILE]]\n"
+                     "             [--counters] [--record=FILE | --replay=FILE] [--debug]\n"
+                     "             [--limit=N] [--time-limit=MS]\n"
+                     "             [path to image file]...\n"
+                     "       lc3vm --batch=MANIFEST [--engine=interp|lockstep] [--jobs=N] [--limit=N]\n"
+                     "       lc3vm --serve=PORT [--jobs=N] [--restore=FILE] [path to image file]...\n"
+                     "       lc3vm --fork-server=SOCKET [--fork-at=ADDR] [--restore=FILE] [path to image file]...\n";
         return 0;
     }
 
-    if (!read_image(argv[1])) {
-        std::cout << "** Failed to read image **\n";
+    /* Batch runs are headless by nature, results go to stdout as JSON lines */
+    if (batch_path) {
+        batch_options.limit = limit.value_or(batch_options.limit);
+        std::ios::sync_with_stdio(false);
+        const auto failed { Batch::run(batch_path, std::cout, batch_options) };
+        if (!failed) {
+            std::cout << "** Failed to read manifest **\n";
+            return -1;
+        }
+        return *failed ? 1 : 0;
+    }
+
+    if (use_jit && !Jit::supported()) {
+        std::cout << "** JIT is not supported on this platform, using the interpreter **\n";
+    }
+    if (use_jit && profile_path) {
+        std::cout << "** Profiling needs the interpreter, not using the JIT **\n";
+        use_jit = false;
+    }
+    if (use_jit && (record_path || replay_path)) {
+        std::cout << "** Tracing needs the interpreter, not using the JIT **\n";
+        use_jit = false;
+    }
+    if (use_jit && debug) {
+        std::cout << "** Debugging needs the interpreter, not using the JIT **\n";
+        use_jit = false;
+    }
+    if (use_jit && (limit || time_limit)) {
+        std::cout << "** Limits need the interpreter, not using the JIT **\n";
+        use_jit = false;
+    }
+    if (use_jit && serve_port) {
+        std::cout << "** Hosting needs the interpreter, not using the JIT **\n";
+        use_jit = false;
+    }
+    if (use_jit && fork_server_path) {
+        std::cout << "** The fork server needs the interpreter, not using the JIT **\n";
+        use_jit = false;
+    }
+    if (serve_port && !Host::supported()) {
+        std::cout << "** Hosting is not supported on this platform **\n";
+        return -1;
+    }
+    if (fork_server_path && !ForkServer::supported()) {
+        std::cout << "** The fork server is not supported on this platform **\n";
         return -1;
     }
 
-    std::signal(SIGINT, handle_interrupt);
-    disable_input_buffering();
+    /*
+     * Headless runs never touch the terminal. Input is a script (a file, or stdin
+     * read like one) so the run only depends on its contents, and output is only
+     * flushed at the end unless --flush says otherwise.
+     */
+    std::ifstream input_file;
+    std::ofstream output_file;
+    if (input_path) {
+        input_file.open(input_path, std::ios::binary);
+        if (!input_file.is_open()) {
+            std::cout << "** Failed to open input **\n";
+            return -1;
+        }
+    }
+    if (output_path) {
+        output_file.open(output_path, std::ios::binary | std::ios::trunc);
+        if (!output_file.is_open()) {
+            std::cout << "** Failed to open output **\n";
+            return -1;
+        }
+    }
+    if (headless) {
+        std::ios::sync_with_stdio(false);
+        std::cin.tie(nullptr);
+        flush = flush.value_or(FlushPolicy { Display::ON_HALT });
+    }
 
-    /* The default value in the COND register is 0 */
-    Registers::write(Registers::COND, CondFlags::ZERO);
+    /* The debugger reads its commands from stdin, so without --input the program gets no input at all */
+    std::istringstream no_input;
+    std::istream &in { input_path ? input_file : debug ? no_input : std::cin };
+    std::ostream &out { output_path ? output_file : std::cout };
+    const auto machine { std::make_unique<Machine>(in, out, headless ? Keyboard::SCRIPTED : Keyboard::ASYNC) };
+    if (flush) {
+        machine->display.set_policy(flush->policy, flush->every);
+    }
 
-    /* Program counter needs to be in the starting position */
-    Registers::write(Registers::PC, Registers::pc_start);
+    /* Every image is placed at its own origin, e.g. an OS image followed by a user program */
+    for (const char *const image : images) {
+        if (!Image::read(*machine, image)) {
+            std::cout << "** Failed to read image **\n";
+            return -1;
+        }
+    }
 
-    bool running { true };
-    while (running) {
-        /*
-         * No Registers::read() because the value is copied when using read, and we
-         * need to modify it, but doing another read and write after every instruction is painful.
-         */
-        const std::uint16_t instr { Memory::read(Registers::vals[Registers::PC]++) };
+    /* A snapshot replaces all of memory, so it wins over any images */
+    std::uint64_t executed {};
+    if (restore_path && !Snapshot::restore(*machine, restore_path, executed)) {
+        std::cout << "** Failed to read snapshot **\n";
+        return -1;
+    }
 
-        const std::uint16_t opcode ( instr >> 12 );
+    /* Every connection gets a copy of the loaded machine, which never runs itself */
+    if (serve_port) {
+        if (!Host::serve(*machine, Host::Options { *serve_port, batch_options.threads })) {
+            std::cout << "** Failed to listen on port " << *serve_port << " **\n";
+            return -1;
+        }
+        return 0;
+    }
 
-        if (opcode == Opcodes::TRAP && (instr & 0xFF) == Trap::HALT) {
-            running = false;
-            std::cout << "\n** Program Halted **\n" << std::flush;
+    /* Every request forks the loaded machine, which is only run up to --fork-at here */
+    if (fork_server_path) {
+        const ForkServer::Failure failure { ForkServer::serve(*machine, { fork_server_path, fork_at }) };
+        if (failure == ForkServer::HALTED_BEFORE_START) {
+            std::cout << "** Program halted before the fork point **\n";
+        } else if (failure == ForkServer::ACCEPT_FAILED) {
+            std::cout << "** Failed to accept on " << fork_server_path << " **\n";
         } else {
-            Opcodes::opcode_funcs[opcode](instr);
+            std::cout << "** Failed to listen on " << fork_server_path << " **\n";
         }
+        return -1;
     }
 
-    restore_input_buffering();
+    /* Recording starts from the loaded machine, a replay has to start from the same one */
+    std::unique_ptr<Trace> trace;
+    if (record_path || replay_path) {
+        trace = record_path ? Trace::record(record_path) : Trace::replay(replay_path);
+        if (!trace) {
+            std::cout << "** Failed to open trace **\n";
+            return -1;
+        }
+        if (!trace->begin(*machine, executed)) {
+            std::cout << "** Trace was recorded from a different machine **\n";
+            return -1;
+        }
+        machine->trace = trace.get();
+    }
+
+    if (!headless) {
+        std::signal(SIGINT, handle_interrupt);
+        disable_input_buffering();
+    }
+    if (record_path) {
+        std::signal(SIGINT, interrupt_recording);
+    }
+
+    if (snapshot_at && !run_to_snapshot(*machine, *snapshot_at, snapshot_path, executed, headless)) {
+        if (trace) {
+            trace->end(executed);
+        }
+        std::cout << "** Program halted before the snapshot point **\n";
+        if (!headless) {
+            restore_input_buffering();
+        }
+        return 0;
+    }
+
+    /* Runs until the program executes HALT */
+    if (debug) {
+        Debugger::run(*machine, std::cin, std::cout);
+    } else if (profile_path) {
+        const auto profile { std::make_unique<Profile>() };
+        std::optional<Counters::Sampler> sampler;
+        if (counters) {
+            sampler.emplace(*profile);
+            if (!sampler->running()) {
+                std::cout << (Counters::supported() ? "** Host counters are not available, profiling without them **\n"
+                                                    : "** Host counters are not supported on this platform **\n");
+            }
+        }
+        const Interpreter::Stop stop { Interpreter::run(*machine, *profile) };
+        sampler.reset();
+        machine->display.flush();
+
+        profile->report(std::cerr);
+        std::ofstream json { profile_path, std::ios::trunc };
+        profile->write_json(json);
+        if (!json) {
+            std::cout << "** Failed to write profile **\n";
+        }
+        if (stop == Interpreter::FAULTED) {
+            Interpreter::panic(*machine);
+        }
+    } else if (use_jit) {
+        Jit::run(*machine);
+    } else if (limit || time_limit) {
+        const Interpreter::Quota quota {
+            limit.value_or(std::numeric_limits<std::uint64_t>::max()),
+            time_limit ? std::chrono::steady_clock::now() + *time_limit : std::chrono::steady_clock::time_point::max(),
+        };
+        run_limited(*machine, quota, snapshot_path, executed);
+    } else if (trace) {
+        const Interpreter::Stop stop { run_counted(*machine, std::numeric_limits<std::uint64_t>::max(), executed) };
+        if (stop == Interpreter::FAULTED) {
+            fault(*machine, executed);
+        }
+        if (stop == Interpreter::PREEMPTED) {
+            stop_traced(*machine, executed, headless);
+        }
+        trace->end(executed);
+        if (trace->diverged()) {
+            std::cout << "** Replay diverged from the recording by instruction " << trace->divergence() << " **\n";
+        }
+    } else if (Interpreter::run(*machine) == Interpreter::FAULTED) {
+        Interpreter::panic(*machine);
+    }
+
+    if (!headless) {
+        restore_input_buffering();
+    }
     return 0;
 }
\ No newline at end of file
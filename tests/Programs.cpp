@@ -0,0 +1,424 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "Programs.hpp"
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include "Opcodes.hpp"
+#include "Registers.hpp"
+#include "Trap.hpp"
+
+namespace {
+
+    /* Assembles words at pc_start, PC relative operands are filled in once their label is placed */
+    class Assembler {
+    public:
+        using Label = std::size_t;
+
+        Label label() {
+            labels.push_back(unplaced);
+            return labels.size() - 1;
+        }
+
+        void place(const Label label) {
+            labels[label] = here();
+        }
+
+        std::uint16_t here() const {
+            return static_cast<std::uint16_t>(Registers::pc_start + words.size());
+        }
+
+        /* Words assembled so far */
+        std::size_t size() const {
+            return words.size();
+        }
+
+        void emit(const std::uint16_t word) {
+            words.push_back(word);
+        }
+
+        /* word with its low bits an offset from the next word to label */
+        void emit(const std::uint16_t word, const Label label, const int bits) {
+            fixups.push_back({ words.size(), label, bits });
+            words.push_back(word);
+        }
+
+        /* The address of label */
+        void fill(const Label label) {
+            emit(0, label, 16);
+        }
+
+        std::vector<std::uint8_t> image() const {
+            std::vector<std::uint16_t> resolved { words };
+            for (const Fixup &fixup : fixups) {
+                const std::uint16_t target { labels[fixup.label] };
+                if (target == unplaced) {
+                    throw std::logic_error { "label was never placed" };
+                }
+                if (fixup.bits == 16) {
+                    resolved[fixup.at] = target;
+                    continue;
+                }
+                const int offset { target - (Registers::pc_start + static_cast<int>(fixup.at) + 1) };
+                if (offset < -(1 << (fixup.bits - 1)) || offset >= 1 << (fixup.bits - 1)) {
+                    throw std::logic_error { "offset out of range" };
+                }
+                resolved[fixup.at] |= offset & ((1 << fixup.bits) - 1);
+            }
+
+            std::vector<std::uint8_t> bytes { Registers::pc_start >> 8, Registers::pc_start & 0xFF };
+            for (const std::uint16_t word : resolved) {
+                bytes.push_back(word >> 8);
+                bytes.push_back(word & 0xFF);
+            }
+            return bytes;
+        }
+
+    private:
+        struct Fixup {
+            std::size_t at;
+            Label label;
+            int bits;
+        };
+
+        static constexpr std::uint16_t unplaced { 0 };
+
+        std::vector<std::uint16_t> words;
+        std::vector<std::uint16_t> labels;
+        std::vector<Fixup> fixups;
+    };
+
+    /* Instruction encodings, offsets are left zero for Assembler::emit to fill in */
+    constexpr std::uint16_t op(const int opcode) {
+        return static_cast<std::uint16_t>(opcode << 12);
+    }
+
+    constexpr std::uint16_t add(const int dr, const int sr1, const int sr2) {
+        return op(Opcodes::ADD) | dr << 9 | sr1 << 6 | sr2;
+    }
+
+    constexpr std::uint16_t add_imm(const int dr, const int sr1, const int imm) {
+        return op(Opcodes::ADD) | dr << 9 | sr1 << 6 | 0x20 | (imm & 0x1F);
+    }
+
+    constexpr std::uint16_t and_(const int dr, const int sr1, const int sr2) {
+        return op(Opcodes::AND) | dr << 9 | sr1 << 6 | sr2;
+    }
+
+    constexpr std::uint16_t and_imm(const int dr, const int sr1, const int imm) {
+        return op(Opcodes::AND) | dr << 9 | sr1 << 6 | 0x20 | (imm & 0x1F);
+    }
+
+    constexpr std::uint16_t not_(const int dr, const int sr) {
+        return op(Opcodes::NOT) | dr << 9 | sr << 6 | 0x3F;
+    }
+
+    constexpr std::uint16_t br(const int nzp) {
+        return op(Opcodes::BR) | nzp << 9;
+    }
+
+    /* LD, ST, LDI, STI and LEA */
+    constexpr std::uint16_t pc_relative(const int opcode, const int reg) {
+        return op(opcode) | reg << 9;
+    }
+
+    /* LDR and STR */
+    constexpr std::uint16_t base_offset(const int opcode, const int reg, const int base, const int offset) {
+        return op(opcode) | reg << 9 | base << 6 | (offset & 0x3F);
+    }
+
+    constexpr std::uint16_t jsr() {
+        return op(Opcodes::JSR) | 0x0800;
+    }
+
+    constexpr std::uint16_t jsrr(const int base) {
+        return op(Opcodes::JSR) | base << 6;
+    }
+
+    constexpr std::uint16_t ret() {
+        return op(Opcodes::JMP) | Registers::R7 << 6;
+    }
+
+    constexpr std::uint16_t trap(const int vector) {
+        return op(Opcodes::TRAP) | vector;
+    }
+
+    /* Code stays below this many words so every PC relative operand reaches the data after it */
+    constexpr std::size_t code_limit { 160 };
+
+    /* R6 holds the address of the data words and R7 is left for JSR, the body computes with R0 - R5 */
+    constexpr int data_base { Registers::R6 };
+    constexpr std::size_t data_words { 32 };
+
+    class Generator {
+    public:
+        explicit Generator(const std::uint32_t seed) : random { seed } {}
+
+        std::vector<std::uint8_t> generate() {
+            for (int reg { Registers::R0 }; reg <= Registers::R5; ++reg) {
+                inits[reg] = a.label();
+            }
+            for (Assembler::Label &label : scratch) {
+                label = a.label();
+            }
+            for (Assembler::Label &label : patches) {
+                label = a.label();
+            }
+
+            a.emit(pc_relative(Opcodes::LEA, data_base), data, 9);
+            for (int reg { Registers::R0 }; reg <= Registers::R5; ++reg) {
+                a.emit(pc_relative(Opcodes::LD, reg), inits[reg], 9);
+            }
+
+            // The body runs passes times, the back edge is an ADD and BR that fuse
+            const Assembler::Label top { a.label() };
+            a.place(top);
+            const std::size_t blocks { pick(3, 8) };
+            for (std::size_t block {}; block < blocks && a.size() < code_limit; ++block) {
+                const std::size_t count { pick(1, 6) };
+                for (std::size_t i {}; i < count; ++i) {
+                    item();
+                }
+            }
+            a.emit(pc_relative(Opcodes::LD, Registers::R7), passes, 9);
+            a.emit(add_imm(Registers::R7, Registers::R7, -1));
+            a.emit(pc_relative(Opcodes::ST, Registers::R7), passes, 9);
+            a.emit(add_imm(Registers::R7, Registers::R7, 0));
+            a.emit(br(CondFlags::POS), top, 9);
+            a.emit(trap(Trap::HALT));
+
+            subroutines();
+            constants();
+            return a.image();
+        }
+
+    private:
+        std::mt19937 random;
+        Assembler a;
+
+        Assembler::Label data { a.label() };
+        Assembler::Label passes { a.label() };
+        Assembler::Label pointers[2] { a.label(), a.label() };
+        Assembler::Label message { a.label() };
+        Assembler::Label packed { a.label() };
+        Assembler::Label sub_add { a.label() };
+        Assembler::Label sub_not { a.label() };
+        Assembler::Label inits[6] {};
+        Assembler::Label scratch[4] {};
+        Assembler::Label patches[3] {};
+
+        std::size_t pick(const std::size_t lo, const std::size_t hi) {
+            return std::uniform_int_distribution<std::size_t> { lo, hi }(random);
+        }
+
+        int reg() {
+            return static_cast<int>(pick(Registers::R0, Registers::R5));
+        }
+
+        /* Any register may be read, including the data base and the return address */
+        int source() {
+            return static_cast<int>(pick(Registers::R0, Registers::R7));
+        }
+
+        int imm5() {
+            return static_cast<int>(pick(0, 31)) - 16;
+        }
+
+        int offset() {
+            return static_cast<int>(pick(0, data_words - 1));
+        }
+
+        template <std::size_t n>
+        Assembler::Label any(const Assembler::Label (&labels)[n]) {
+            return labels[pick(0, n - 1)];
+        }
+
+        void item() {
+            switch (pick(0, 19)) {
+                case 0:
+                case 1:
+                    a.emit(pick(0, 1) ? add(reg(), source(), source()) : add_imm(reg(), source(), imm5()));
+                    break;
+                case 2:
+                    a.emit(pick(0, 1) ? and_(reg(), source(), source()) : and_imm(reg(), source(), imm5()));
+                    break;
+                case 3:
+                    a.emit(not_(reg(), source()));
+                    break;
+                case 4:
+                    a.emit(base_offset(Opcodes::LDR, reg(), data_base, offset()));
+                    break;
+                case 5:
+                    a.emit(base_offset(Opcodes::STR, source(), data_base, offset()));
+                    break;
+                case 6:
+                    a.emit(pick(0, 1) ? pc_relative(Opcodes::LD, reg()) : pc_relative(Opcodes::ST, source()),
+                           any(scratch), 9);
+                    break;
+                case 7:
+                    a.emit(pick(0, 1) ? pc_relative(Opcodes::LDI, reg()) : pc_relative(Opcodes::STI, source()),
+                           any(pointers), 9);
+                    break;
+                case 8:
+                    a.emit(pc_relative(Opcodes::LEA, reg()), data, 9);
+                    break;
+                case 9:
+                    branch(false);
+                    break;
+                case 10:
+                    branch(true);
+                    break;
+                case 11:
+                    a.emit(jsr(), sub_add, 11);
+                    break;
+                case 12:
+                    a.emit(pc_relative(Opcodes::LEA, Registers::R7), sub_not, 9);
+                    a.emit(jsrr(Registers::R7));
+                    break;
+                case 13: {
+                    // Load, bump and store back one data word (LDR_ADD_STR)
+                    const int val { reg() };
+                    const int at { offset() };
+                    a.emit(base_offset(Opcodes::LDR, val, data_base, at));
+                    a.emit(add_imm(val, val, imm5()));
+                    a.emit(base_offset(Opcodes::STR, val, data_base, at));
+                    break;
+                }
+                case 14: {
+                    // Clear and add (AND_ZERO_ADD)
+                    const int cleared { reg() };
+                    a.emit(and_imm(cleared, source(), 0));
+                    a.emit(add_imm(reg(), cleared, imm5()));
+                    break;
+                }
+                case 15:
+                    // LEA_PUTS, or LEA and PUTSP which do not fuse
+                    if (pick(0, 1)) {
+                        a.emit(pc_relative(Opcodes::LEA, Registers::R0), message, 9);
+                        a.emit(trap(Trap::PUTS));
+                    } else {
+                        a.emit(pc_relative(Opcodes::LEA, Registers::R0), packed, 9);
+                        a.emit(trap(Trap::PUTSP));
+                    }
+                    break;
+                case 16:
+                    a.emit(trap(Trap::OUT));
+                    break;
+                case 17:
+                    patch_next();
+                    break;
+                default:
+                    patch_fused();
+                    break;
+            }
+        }
+
+        /* A forward branch over a few instructions, fused with the ADD before it if fused */
+        void branch(const bool fused) {
+            const Assembler::Label over { a.label() };
+            if (fused) {
+                a.emit(add_imm(reg(), source(), imm5()));
+            }
+            a.emit(br(static_cast<int>(pick(0, 7))), over, 9);
+            for (std::size_t i { pick(0, 3) }; i > 0; --i) {
+                a.emit(add_imm(reg(), source(), imm5()));
+            }
+            a.place(over);
+        }
+
+        /* Stores an instruction over the word right after the store, which runs next */
+        void patch_next() {
+            const Assembler::Label slot { a.label() };
+            a.emit(pc_relative(Opcodes::LD, Registers::R7), any(patches), 9);
+            a.emit(pc_relative(Opcodes::ST, Registers::R7), slot, 9);
+            a.place(slot);
+            a.emit(add_imm(Registers::R7, Registers::R7, 0));
+        }
+
+        /*
+         * Patches the second word of an AND_ZERO_ADD or ADD_IMM_BR pair, but only on passes
+         * where R7 (what R5 held) is not zero, so the pair runs both fused and patched
+         */
+        void patch_fused() {
+            const Assembler::Label skip { a.label() };
+            const Assembler::Label second { a.label() };
+            a.emit(add_imm(Registers::R7, Registers::R5, 0));
+            a.emit(br(CondFlags::ZERO), skip, 9);
+            a.emit(pc_relative(Opcodes::LD, Registers::R7), any(patches), 9);
+            a.emit(pc_relative(Opcodes::ST, Registers::R7), second, 9);
+            a.place(skip);
+
+            const int val { reg() };
+            if (pick(0, 1)) {
+                a.emit(and_imm(val, val, 0));
+                a.place(second);
+                a.emit(add_imm(reg(), val, imm5()));
+            } else {
+                const Assembler::Label over { a.label() };
+                a.emit(add_imm(val, val, imm5()));
+                a.place(second);
+                a.emit(br(static_cast<int>(pick(0, 7))), over, 9);
+                a.emit(add_imm(reg(), source(), imm5()));
+                a.place(over);
+            }
+        }
+
+        void subroutines() {
+            a.place(sub_add);
+            a.emit(add_imm(Registers::R3, Registers::R3, 3));
+            a.emit(ret());
+            a.place(sub_not);
+            a.emit(not_(Registers::R2, Registers::R2));
+            a.emit(ret());
+        }
+
+        void constants() {
+            // What patches store over code, none of them writes R6 or R7
+            const std::uint16_t patch_words[] {
+                add_imm(Registers::R1, Registers::R1, 5),
+                not_(Registers::R0, Registers::R0),
+                and_(Registers::R3, Registers::R3, Registers::R2),
+            };
+            for (std::size_t i {}; i < std::size(patches); ++i) {
+                a.place(patches[i]);
+                a.emit(patch_words[i]);
+            }
+
+            for (const Assembler::Label init : inits) {
+                a.place(init);
+                a.emit(static_cast<std::uint16_t>(random()));
+            }
+            a.place(passes);
+            a.emit(static_cast<std::uint16_t>(pick(1, 8)));
+
+            a.place(message);
+            for (const char c : { 'h', 'i', '\n', '\0' }) {
+                a.emit(static_cast<std::uint8_t>(c));
+            }
+            a.place(packed);
+            a.emit('o' << 8 | 'k');
+            a.emit('\n');
+
+            for (const Assembler::Label label : scratch) {
+                a.place(label);
+                a.emit(static_cast<std::uint16_t>(random()));
+            }
+            a.place(pointers[0]);
+            a.fill(data);
+            a.place(pointers[1]);
+            a.fill(scratch[2]);
+
+            a.place(data);
+            for (std::size_t i {}; i < data_words; ++i) {
+                a.emit(static_cast<std::uint16_t>(random()));
+            }
+        }
+    };
+
+}
+
+std::vector<std::uint8_t> generate_program(const std::uint32_t seed) {
+    return Generator { seed }.generate();
+}
@@ -0,0 +1,22 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#ifndef LC3VM_PROGRAMS_HPP
+#define LC3VM_PROGRAMS_HPP
+#include <cstdint>
+#include <vector>
+
+/*
+ * A random program for the differential test, as an object image (big endian origin
+ * followed by the words) that Image::load takes. The same seed always gives the same program.
+ *
+ * Programs start at Registers::pc_start, run a random body a few times and halt. The
+ * body mixes every opcode except RTI and RES with the sequences Decode::fuse turns
+ * into superinstructions, and with stores that patch instructions ahead of them,
+ * some of them the second word of a fused sequence. Loads and stores only reach the
+ * program's own data and the patched words, so every program halts on every engine.
+ */
+std::vector<std::uint8_t> generate_program(std::uint32_t seed);
+
+#endif //LC3VM_PROGRAMS_HPP
@@ -0,0 +1,319 @@
+//
+// Created by Lucas Watkins on 10/18/26.
+//
+
+#include "AotRuntime.hpp"
+#include "Image.hpp"
+#include "Interpreter.hpp"
+#include "Jit.hpp"
+#include "Lockstep.hpp"
+#include "Machine.hpp"
+#include "Notation.hpp"
+#include "Profile.hpp"
+#include "Programs.hpp"
+#include "Snapshot.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Differential test: every engine runs the same generated programs as the reference
+ * stepper (Aot::step, one Opcodes::opcode_funcs call per instruction) and has to end
+ * with the same registers, memory, output and instruction count.
+ */
+
+namespace {
+
+    /* How a program ended */
+    struct Outcome {
+        std::array<std::uint16_t, Registers::COUNT> regs {};
+        std::vector<std::uint16_t> mem;
+        std::string output;
+        std::uint64_t executed {};
+        std::array<std::uint64_t, Opcodes::COUNT> opcodes {}; /* Only counted by the reference and profiled runs */
+        Interpreter::Stop stop {};
+    };
+
+    /* A fresh headless machine with the program loaded, the programs never read the keyboard */
+    struct Guest {
+        std::istringstream in;
+        std::ostringstream out;
+        std::unique_ptr<Machine> machine;
+
+        explicit Guest(const std::vector<std::uint8_t> &image)
+            : machine { std::make_unique<Machine>(in, out, Keyboard::SCRIPTED) } {
+            machine->display.set_policy(Display::ON_HALT);
+            Image::load(*machine, image.data(), image.size());
+        }
+
+        Outcome outcome(const std::uint64_t executed, const Interpreter::Stop stop) {
+            machine->display.flush();
+            return { machine->regs, { machine->mem.begin(), machine->mem.end() }, out.str(), executed, {}, stop };
+        }
+    };
+
+    /* The generated programs run for a few thousand instructions, far fewer than this */
+    constexpr std::uint64_t step_limit { 1'000'000 };
+
+    Outcome reference(const std::vector<std::uint8_t> &image) {
+        Guest guest { image };
+        Machine &m { *guest.machine };
+
+        std::array<std::uint64_t, Opcodes::COUNT> opcodes {};
+        std::uint64_t executed {};
+        bool running { true };
+        while (running && executed < step_limit) {
+            ++opcodes[m.mem[m.regs[Registers::PC]] >> 12];
+            running = Aot::step(m);
+            ++executed;
+        }
+
+        Outcome outcome { guest.outcome(executed, running ? Interpreter::OUT_OF_BUDGET : Interpreter::HALTED) };
+        outcome.opcodes = opcodes;
+        return outcome;
+    }
+
+    Outcome plain(const std::vector<std::uint8_t> &image, std::mt19937 &) {
+        Guest guest { image };
+        const Interpreter::Stop stop { Interpreter::run(*guest.machine) };
+        return guest.outcome(0, stop);
+    }
+
+    Outcome counted(const std::vector<std::uint8_t> &image, std::mt19937 &) {
+        Guest guest { image };
+        std::uint64_t budget { step_limit };
+        const Interpreter::Stop stop { Interpreter::run(*guest.machine, budget) };
+        return guest.outcome(step_limit - budget, stop);
+    }
+
+    /* Budgets of a few instructions, so runs also stop and resume inside fused sequences */
+    Outcome sliced(const std::vector<std::uint8_t> &image, std::mt19937 &random) {
+        Guest guest { image };
+        std::uint64_t executed {};
+        Interpreter::Stop stop { Interpreter::OUT_OF_BUDGET };
+        while (stop == Interpreter::OUT_OF_BUDGET && executed < step_limit) {
+            const std::uint64_t slice { std::uniform_int_distribution<std::uint64_t> { 1, 40 }(random) };
+            std::uint64_t budget { slice };
+            stop = Interpreter::run(*guest.machine, budget);
+            executed += slice - budget;
+        }
+        return guest.outcome(executed, stop);
+    }
+
+    Outcome preemptible(const std::vector<std::uint8_t> &image, std::mt19937 &random) {
+        Guest guest { image };
+        std::uint64_t executed {};
+        Interpreter::Stop stop { Interpreter::PREEMPTED };
+        while (stop == Interpreter::PREEMPTED && executed < step_limit) {
+            const Interpreter::Quota quota { std::uniform_int_distribution<std::uint64_t> { 1, 200 }(random),
+                                             std::chrono::steady_clock::time_point::max() };
+            stop = Interpreter::run(*guest.machine, quota, executed);
+        }
+        return guest.outcome(executed, stop);
+    }
+
+    Outcome profiled(const std::vector<std::uint8_t> &image, std::mt19937 &) {
+        Guest guest { image };
+        const auto profile { std::make_unique<Profile>() };
+        const Interpreter::Stop stop { Interpreter::run(*guest.machine, *profile) };
+
+        std::uint64_t executed {};
+        for (const std::uint64_t count : profile->opcodes) {
+            executed += count;
+        }
+        Outcome outcome { guest.outcome(executed, stop) };
+        outcome.opcodes = profile->opcodes;
+        return outcome;
+    }
+
+    /* One snapshot file for the whole run, named so that runs side by side do not share it */
+    const std::string &snapshot_path() {
+        static const std::string path {
+            (std::filesystem::temp_directory_path() / ("lc3vm_tests." + std::to_string(std::random_device {}()) + ".snap"))
+                .string()
+        };
+        return path;
+    }
+
+    /*
+     * Runs the program a slice at a time, each slice on a fresh machine restored from
+     * the snapshot the slice before it saved, until a slice stops with anything but
+     * suspended. The snapshot is saved to the file it was restored from while the
+     * machine's memory may still be mapped from it.
+     */
+    template <typename Slice>
+    Outcome resumed(const std::vector<std::uint8_t> &image, const Interpreter::Stop suspended, Slice slice) {
+        std::string output;
+        std::uint64_t executed {};
+        for (bool restore { false };; restore = true) {
+            Guest guest { image };
+            // A snapshot that does not restore shows up as a stop the reference never ends with
+            if (restore && !Snapshot::restore(*guest.machine, snapshot_path().c_str(), executed)) {
+                return guest.outcome(executed, Interpreter::FAULTED);
+            }
+
+            const Interpreter::Stop stop { slice(*guest.machine, executed) };
+            Outcome outcome { guest.outcome(executed, stop) };
+            output += outcome.output;
+            if (stop != suspended || executed >= step_limit
+                || !Snapshot::save(*guest.machine, snapshot_path().c_str(), executed)) {
+                outcome.output = output;
+                return outcome;
+            }
+        }
+    }
+
+    /* Counted slices, like --snapshot-at=count:N and --restore */
+    Outcome snapshotted(const std::vector<std::uint8_t> &image, std::mt19937 &random) {
+        return resumed(image, Interpreter::OUT_OF_BUDGET, [&](Machine &m, std::uint64_t &executed) {
+            const std::uint64_t slice { std::uniform_int_distribution<std::uint64_t> { 1, 2000 }(random) };
+            std::uint64_t budget { slice };
+            const Interpreter::Stop stop { Interpreter::run(m, budget) };
+            executed += slice - budget;
+            return stop;
+        });
+    }
+
+    /* Suspended programs, like --limit=N run again with --restore until the program halts */
+    Outcome limited(const std::vector<std::uint8_t> &image, std::mt19937 &random) {
+        return resumed(image, Interpreter::PREEMPTED, [&](Machine &m, std::uint64_t &executed) {
+            const Interpreter::Quota quota { std::uniform_int_distribution<std::uint64_t> { 1, 2000 }(random),
+                                             std::chrono::steady_clock::time_point::max() };
+            return Interpreter::run(m, quota, executed);
+        });
+    }
+
+    /* Jit::run only returns once the program halted */
+    Outcome jit(const std::vector<std::uint8_t> &image, std::mt19937 &) {
+        Guest guest { image };
+        Jit::run(*guest.machine);
+        return guest.outcome(0, Interpreter::HALTED);
+    }
+
+    /* Lockstep only reports each lane's output, so the registers and memory are the reference's */
+    Outcome lockstep(const std::vector<std::uint8_t> &image, std::mt19937 &) {
+        Guest guest { image };
+        std::vector<Lockstep::Lane> lanes(Lockstep::lanes, { {}, step_limit });
+        Lockstep::Engine {}.run(*guest.machine, lanes);
+
+        // Every lane runs the same program, a lane that ended unlike the first is the one to report
+        const Lockstep::Lane *reported { &lanes[0] };
+        for (const Lockstep::Lane &lane : lanes) {
+            if (lane.stop != lanes[0].stop || lane.executed != lanes[0].executed || lane.output != lanes[0].output) {
+                reported = &lane;
+                break;
+            }
+        }
+        return { {}, {}, reported->output, reported->executed, {}, reported->stop };
+    }
+
+    struct Engine {
+        std::string_view name;
+        Outcome (*run)(const std::vector<std::uint8_t> &, std::mt19937 &);
+        bool counts;  /* Whether Outcome::executed is set */
+        bool profile; /* Whether Outcome::opcodes is set */
+        bool state;   /* Whether Outcome::regs and Outcome::mem are set */
+    };
+
+    /* What differs between an engine's outcome and the reference's, empty if nothing does */
+    std::string compare(const Engine &engine, const Outcome &expected, const Outcome &actual) {
+        std::ostringstream diff;
+        if (actual.stop != expected.stop) {
+            diff << "stopped with " << actual.stop << " instead of " << expected.stop;
+        } else if (engine.counts && actual.executed != expected.executed) {
+            diff << "executed " << actual.executed << " instructions instead of " << expected.executed;
+        } else if (engine.profile && actual.opcodes != expected.opcodes) {
+            diff << "counted different opcodes";
+        } else if (actual.output != expected.output) {
+            diff << "printed different output";
+        } else if (engine.state) {
+            for (int reg {}; reg < Registers::COUNT && diff.view().empty(); ++reg) {
+                if (actual.regs[reg] != expected.regs[reg]) {
+                    diff << "register " << reg << " is " << Notation::Hex { actual.regs[reg] } << " instead of "
+                         << Notation::Hex { expected.regs[reg] };
+                }
+            }
+            for (std::size_t addr {}; addr < expected.mem.size() && diff.view().empty(); ++addr) {
+                if (actual.mem[addr] != expected.mem[addr]) {
+                    diff << "memory at " << Notation::Hex { addr } << " is " << Notation::Hex { actual.mem[addr] }
+                         << " instead of " << Notation::Hex { expected.mem[addr] };
+                }
+            }
+        }
+        return diff.str();
+    }
+
+}
+
+int main(const int argc, const char *const argv[]) {
+
+    std::uint32_t programs { 200 };
+    std::uint32_t first { 1 };
+
+    for (int i { 1 }; i < argc; ++i) {
+        const std::string_view arg { argv[i] };
+        const std::string_view value { arg.substr(arg.find('=') + 1) };
+
+        if (arg.starts_with("--programs=") && Notation::parse_number<std::uint32_t>(value)) {
+            programs = *Notation::parse_number<std::uint32_t>(value);
+        } else if (arg.starts_with("--seed=") && Notation::parse_number<std::uint32_t>(value)) {
+            first = *Notation::parse_number<std::uint32_t>(value);
+        } else {
+            std::cout << "Usage: lc3vm_tests [--programs=N] [--seed=FIRST]\n";
+            return 0;
+        }
+    }
+
+    std::vector<Engine> engines {
+        { "interp", plain, false, false, true },
+        { "counted", counted, true, false, true },
+        { "sliced", sliced, true, false, true },
+        { "preemptible", preemptible, true, false, true },
+        { "profiled", profiled, true, true, true },
+        { "snapshotted", snapshotted, true, false, true },
+        { "limited", limited, true, false, true },
+    };
+    if (Jit::supported()) {
+        engines.push_back({ "jit", jit, false, false, true });
+    }
+    engines.push_back({ "lockstep", lockstep, true, false, false });
+
+    int failures {};
+    for (std::uint32_t seed { first }; seed < first + programs; ++seed) {
+        const std::vector<std::uint8_t> image { generate_program(seed) };
+        const Outcome expected { reference(image) };
+        if (expected.stop != Interpreter::HALTED) {
+            std::cout << "** Program " << seed << " did not halt on the reference stepper **\n";
+            ++failures;
+            continue;
+        }
+
+        for (const Engine &engine : engines) {
+            std::mt19937 random { seed };
+            const std::string diff { compare(engine, expected, engine.run(image, random)) };
+            if (!diff.empty()) {
+                std::cout << "** Program " << seed << " on " << engine.name << ": " << diff << " **\n";
+                ++failures;
+            }
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::remove(snapshot_path(), error);
+
+    if (failures) {
+        std::cout << "** " << failures << " mismatches, rerun one with --seed=N --programs=1 **\n";
+        return 1;
+    }
+    std::cout << "** " << programs << " programs agree on " << engines.size() << " engines **\n";
+    return 0;
+}